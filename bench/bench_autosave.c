@@ -0,0 +1,123 @@
+// bench/bench_autosave.c — autosave cost on a large session
+//
+// 10k tabs with a full back window each. Every round visits one page in the
+// active tab and saves, as autosave does after a command. "full" invalidates
+// every tab first (what each save used to cost); "incremental" lets the
+// per-tab fragment cache do its job. The last pass autosaves to ".lz" and
+// compares bytes written, and both files are loaded back.
+//
+// Then a session whose weight is the next-visit model: a few tabs, PRED_URLS
+// urls visited in a loop so every one has a successor row. "with model" is
+// what each autosave cost while it wrote the model; autosave now leaves it
+// to the save at exit.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "tabs.h"
+#include "session.h"
+
+enum { TABS = 10000, DEPTH = 8, ROUNDS = 50, PRED_URLS = 20000 };
+
+static double now_ms(void) {
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static long file_size(const char *path) {
+    FILE *f = fopen(path, "rb"); if (!f) return -1;
+    fseek(f, 0, SEEK_END); long n = ftell(f); fclose(f);
+    return n;
+}
+
+static double run(TabManager *tm, const char *path, int invalidate_all) {
+    char url[128];
+    double t0 = now_ms();
+    for (int r = 0; r < ROUNDS; ++r) {
+        snprintf(url, sizeof url, "https://round.example.org/%d", r);
+        browser_visit(tm_active(tm), url);
+        if (invalidate_all) for (int i = 0; i < tm->count; ++i) tm->tabs[i]->version++;
+        save_session_json(path, tm);
+    }
+    return (now_ms() - t0) / ROUNDS;
+}
+
+static double run_pred(TabManager *tm, const char *path, int with_model) {
+    char url[128];
+    double t0 = now_ms();
+    for (int r = 0; r < ROUNDS; ++r) {
+        snprintf(url, sizeof url, "https://site%d.example.net/item/%d", r * 7919 % PRED_URLS % 97, r * 7919 % PRED_URLS);
+        browser_visit(tm_active(tm), url);
+        if (with_model) save_session_json(path, tm);
+        else save_session_json_nomodel(path, tm);
+    }
+    return (now_ms() - t0) / ROUNDS;
+}
+
+static void bench_predictor(const char *path) {
+    TabManager tm; tm_init(&tm, 5);
+    char url[128];
+    for (int t = 0; t < 4; ++t) tm_new_tab(&tm, "about:blank");
+    for (int i = 0; i < 2 * PRED_URLS; ++i) {
+        snprintf(url, sizeof url, "https://site%d.example.net/item/%d", i % PRED_URLS % 97, i % PRED_URLS);
+        browser_visit(tm.tabs[i % 4], url);
+    }
+    tm_switch(&tm, 0);
+    double full = run_pred(&tm, path, 1);
+    long full_bytes = file_size(path);
+    double lite = run_pred(&tm, path, 0);
+    long lite_bytes = file_size(path);
+    printf("bench_autosave: %d predicted urls in %d tabs, %d saves each\n", tm.pred.count, tm.count, ROUNDS);
+    printf("  with model        : %8.3f ms/save | %ld bytes\n", full, full_bytes);
+    printf("  autosave          : %8.3f ms/save | %ld bytes | x%.1f\n", lite, lite_bytes, full / lite);
+    save_session_json(path, &tm);   // as autosave_final at exit
+    TabManager back; tm_init(&back, 5);
+    int ok = load_session_json(path, &back, 5) && back.pred.count == tm.pred.count;
+    if (!ok) printf("  round-trip FAILED\n");
+    tm_destroy(&back);
+    remove(path);
+    tm_destroy(&tm);
+}
+
+int main(void) {
+    const char *path = "bench_autosave.tmp.json";
+    TabManager tm; tm_init(&tm, 5);
+    char url[128];
+    for (int t = 0; t < TABS; ++t) {
+        snprintf(url, sizeof url, "https://tab%d.example.com/", t);
+        int id = tm_new_tab(&tm, url);
+        for (int j = 0; j < DEPTH; ++j) {
+            snprintf(url, sizeof url, "https://www.example%d.com/path/%d/page-%d.html", t % 97, j % 13, j);
+            browser_visit(tm.tabs[id], url);
+        }
+    }
+    tm_switch(&tm, 0);
+    save_session_json(path, &tm);   // warm the cache once
+
+    double full = run(&tm, path, 1);
+    double inc  = run(&tm, path, 0);
+    const char *lzpath = "bench_autosave.tmp.json.lz";
+    double lz   = run(&tm, lzpath, 0);
+    long plain_bytes = file_size(path), lz_bytes = file_size(lzpath);
+    printf("bench_autosave: %d tabs, %d saves each\n", TABS, ROUNDS);
+    printf("  full re-serialize : %8.3f ms/save\n", full);
+    printf("  incremental       : %8.3f ms/save | x%.2f\n", inc, full / inc);
+    printf("  incremental + lz  : %8.3f ms/save | %ld -> %ld bytes/save (x%.1f smaller)\n",
+           lz, plain_bytes, lz_bytes, (double)plain_bytes / (double)(lz_bytes > 0 ? lz_bytes : 1));
+
+    const char *paths[2] = { path, lzpath };
+    for (int k = 0; k < 2; ++k) {
+        TabManager back; tm_init(&back, 5);
+        double t0 = now_ms();
+        int ok = load_session_json(paths[k], &back, 5) && back.count == tm.count;
+        printf("  load %-13s: %8.3f ms%s\n", k ? "(lz)" : "(plain)", now_ms() - t0, ok ? "" : "  round-trip FAILED");
+        tm_destroy(&back);
+    }
+
+    remove(path); remove(lzpath);
+    tm_destroy(&tm);
+
+    bench_predictor(path);
+    return 0;
+}
@@ -0,0 +1,100 @@
+// bench/bench_bmimport.c — bulk bookmark import throughput
+//
+// Writes a 300k-entry Netscape HTML export and a Chrome-style JSON export,
+// then imports each with bm_import_stream. A plain fread of the same file
+// is the I/O floor to compare against. A small sample is also fed one byte
+// at a time, which must give the same bookmarks as the chunked import.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bookmarks.h"
+#include "bmimport.h"
+
+enum { ENTRIES = 300000, PER_FOLDER = 500 };
+
+static double now_ms(void) {
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static int add_plain(void *ctx, const char *name, const char *url) {
+    return bm_add((BMList*)ctx, name, url);
+}
+
+static void write_html(const char *path, int n) {
+    FILE *f = fopen(path, "wb");
+    fputs("<!DOCTYPE NETSCAPE-Bookmark-file-1>\n<TITLE>Bookmarks</TITLE>\n<DL><p>\n", f);
+    for (int i = 0; i < n; ++i) {
+        if (i % PER_FOLDER == 0) fprintf(f, "%s<DT><H3 ADD_DATE=\"1700000000\">Folder %d</H3>\n<DL><p>\n", i ? "</DL><p>\n" : "", i / PER_FOLDER);
+        fprintf(f, "    <DT><A HREF=\"https://site%d.example.com/page?id=%d&amp;ref=export\" ADD_DATE=\"1700000000\" TAGS=\"t%d,t%d\">Page %d</A>\n",
+                i % 997, i, i % 7, i % 13, i);
+    }
+    fputs("</DL><p>\n</DL><p>\n", f);
+    fclose(f);
+}
+
+static void write_json(const char *path, int n) {
+    FILE *f = fopen(path, "wb");
+    fputs("{\"roots\":{\"bookmark_bar\":{\"children\":[", f);
+    for (int i = 0; i < n; ++i) {
+        if (i % PER_FOLDER == 0) fprintf(f, "%s{\"children\":[", i ? "]," "\"name\":\"Folder\",\"type\":\"folder\"}," : "");
+        else fputc(',', f);
+        fprintf(f, "{\"date_added\":\"13300000000000000\",\"id\":\"%d\",\"name\":\"Page %d\",\"type\":\"url\",\"url\":\"https://site%d.example.com/page?id=%d\"}",
+                i, i, i % 997, i);
+    }
+    fputs("],\"name\":\"Folder\",\"type\":\"folder\"}],\"name\":\"Bookmarks bar\",\"type\":\"folder\"}},\"version\":1}\n", f);
+    fclose(f);
+}
+
+static int same(const BMList *a, const BMList *b) {
+    if (a->size != b->size) return 0;
+    for (int i = 0; i < a->size; ++i) {
+        const BMItem *x = &a->data[i], *y = &b->data[i];
+        if (strcmp(x->name, y->name) || strcmp(x->url, y->url) || x->ntags != y->ntags) return 0;
+        if ((x->folder == NULL) != (y->folder == NULL) || (x->folder && strcmp(x->folder, y->folder))) return 0;
+    }
+    return 1;
+}
+
+static int run(const char *label, const char *path) {
+    FILE *f = fopen(path, "rb");
+    fseek(f, 0, SEEK_END); long size = ftell(f); fseek(f, 0, SEEK_SET);
+    char *raw = (char*)malloc((size_t)size);
+    double t0 = now_ms();
+    size_t got = fread(raw, 1, (size_t)size, f);
+    double read_ms = now_ms() - t0;
+    fseek(f, 0, SEEK_SET);
+
+    BMList bm; bm_init(&bm);
+    t0 = now_ms();
+    int n = bm_import_stream(&bm, f, add_plain, &bm);
+    double imp_ms = now_ms() - t0;
+    fclose(f);
+    printf("%-5s %6.1f MB  %d bookmarks  import %7.1f ms (%6.1f MB/s)  fread %5.1f ms  lookup '%s' -> %d\n",
+           label, size / 1e6, n, imp_ms, size / 1e3 / imp_ms, read_ms, "Page 4242", bm_find_by_name(&bm, "Page 4242"));
+
+    // byte-at-a-time feed of the first 64KB must match the chunked import
+    size_t sample = got < 65536 ? got : 65536;
+    BMList a, b; bm_init(&a); bm_init(&b);
+    BMImport *im = bmi_open(&a, add_plain, &a);
+    bmi_feed(im, raw, sample); bmi_close(im);
+    im = bmi_open(&b, add_plain, &b);
+    for (size_t i = 0; i < sample; ++i) bmi_feed(im, raw + i, 1);
+    bmi_close(im);
+    int ok = n == ENTRIES && a.size > 0 && same(&a, &b);
+    if (!ok) printf("%s: MISMATCH\n", label);
+    bm_destroy(&a); bm_destroy(&b); bm_destroy(&bm); free(raw);
+    return ok;
+}
+
+int main(void) {
+    const char *html = "bench_bmimport.html", *json = "bench_bmimport.json";
+    write_html(html, ENTRIES);
+    write_json(json, ENTRIES);
+    int ok = run("html", html) & run("json", json);
+    remove(html); remove(json);
+    return !ok;
+}
@@ -0,0 +1,85 @@
+// bench/bench_bmquery.c — tag/folder queries over a large bookmark list
+//
+// 1M bookmarks, 48 tags with skewed popularity (a few tags on most items,
+// most tags rare) and 16 folders. Each query runs once on the bitmap index
+// and once as a linear scan of the items; the two must agree.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bookmarks.h"
+
+enum { ITEMS = 1000000, TAGS = 48, FOLDERS = 16, REPS = 20 };
+
+static double now_ms(void) {
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static unsigned rng = 12345;
+static unsigned next_rand(void) { rng = rng * 1103515245u + 12345u; return rng >> 8; }
+
+static int has_tag(const BMItem *it, const char *t) {
+    for (int i = 0; i < it->ntags; ++i) if (strcmp(it->tags[i], t) == 0) return 1;
+    return 0;
+}
+
+static uint32_t scan(const BMList *bm, const BMQuery *q) {
+    uint32_t n = 0;
+    for (int i = 0; i < bm->size; ++i) {
+        const BMItem *it = &bm->data[i];
+        int ok = 1;
+        for (int k = 0; k < q->nall && ok; ++k) ok = has_tag(it, q->all[k]);
+        if (ok && q->folder) ok = it->folder && strcmp(it->folder, q->folder) == 0;
+        if (ok && q->nany) { int a = 0; for (int k = 0; k < q->nany && !a; ++k) a = has_tag(it, q->any[k]); ok = a; }
+        for (int k = 0; k < q->nnone && ok; ++k) ok = !has_tag(it, q->none[k]);
+        n += (uint32_t)ok;
+    }
+    return n;
+}
+
+int main(void) {
+    char tags[TAGS][16], folders[FOLDERS][16], name[32], url[64];
+    for (int t = 0; t < TAGS; ++t) snprintf(tags[t], sizeof tags[t], "t%d", t);
+    for (int f = 0; f < FOLDERS; ++f) snprintf(folders[f], sizeof folders[f], "f%d", f);
+
+    BMList bm; bm_init(&bm);
+    double t0 = now_ms();
+    for (int i = 0; i < ITEMS; ++i) {
+        snprintf(name, sizeof name, "b%d", i);
+        snprintf(url, sizeof url, "https://site%d.example.com/%d", i % 5000, i);
+        int id = bm_add(&bm, name, url);
+        bm_set_folder(&bm, id, folders[next_rand() % FOLDERS]);
+        // tag t is carried with probability ~ 1/(t+1)
+        for (int t = 0; t < TAGS; ++t) if (next_rand() % (unsigned)(t + 1) == 0) bm_tag(&bm, id, tags[t]);
+    }
+    printf("build: %d bookmarks in %.0f ms\n", ITEMS, now_ms() - t0);
+
+    const char *q1[] = { "t0", "t1" }, *n1[] = { "t2" };
+    const char *q2[] = { "t3" }, *a2[] = { "t20", "t30", "t40" }, *n2[] = { "t5", "t7" };
+    const char *n3[] = { "t1" };
+    struct { const char *label; BMQuery q; } qs[] = {
+        { "--tag t0 --tag t1 --not t2",                 { q1, 2, NULL, 0, n1, 1, NULL } },
+        { "--tag t3 --any t20|t30|t40 --not t5 --not t7", { q2, 1, a2, 3, n2, 2, NULL } },
+        { "--folder f4 --not t1",                       { NULL, 0, NULL, 0, n3, 1, "f4" } },
+    };
+    int bad = 0;
+    for (size_t k = 0; k < sizeof qs / sizeof qs[0]; ++k) {
+        Bitmap out; bmp_init(&out);
+        double a = now_ms();
+        for (int r = 0; r < REPS; ++r) bm_query(&bm, &qs[k].q, &out);
+        double idx_ms = (now_ms() - a) / REPS;
+        uint32_t hits = bmp_count(&out);
+        a = now_ms();
+        uint32_t want = scan(&bm, &qs[k].q);
+        double scan_ms = now_ms() - a;
+        printf("%-48s %7u hits  bitmap %7.3f ms  scan %7.1f ms%s\n",
+               qs[k].label, (unsigned)hits, idx_ms, scan_ms, hits == want ? "" : "  MISMATCH");
+        bad |= hits != want;
+        bmp_free(&out);
+    }
+    bm_destroy(&bm);
+    return bad;
+}
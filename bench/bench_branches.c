@@ -0,0 +1,120 @@
+// bench/bench_branches.c — restoring archived forward stacks
+//
+// First checks what a restore must leave behind: the tab walks back to the
+// branch point (here from the cold tier) instead of visiting it, so the back
+// stack is the one the tab had there, the point keeps its original stamp and
+// the next-visit model records no transition. A branch shared by a tab and
+// its duplicate is written to the session once and shared again once loaded.
+// Then times a visit / back / visit / restore cycle on one tab.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tabs.h"
+#include "session.h"
+
+enum { CYCLES = 200000 };
+
+static double now_ms(void) {
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static int fails;
+
+static void expect(int ok, const char *what) {
+    if (!ok) { printf("  FAILED: %s\n", what); fails++; }
+}
+
+static uint32_t pred_total(const TabManager *tm, const char *url) {
+    const PredRow *r = pred_get(&tm->pred, url);
+    return r ? r->total : 0;
+}
+
+static void check_restore(void) {
+    TabManager tm; tm_init(&tm, 3);
+    tm_set_spill_dir(&tm, ".");
+    int id = tm_new_tab(&tm, "about:blank");
+    Browser *b = tm.tabs[id];
+    browser_visit(b, "a");
+    int64_t a_ts = b->current_ts;
+    browser_visit(b, "b"); browser_visit(b, "c");
+    browser_back(b, 2);                    // at a, forward c, b
+    browser_visit(b, "d");                 // archives [c, b] off a
+    char url[32];
+    for (int i = 0; i < 10; ++i) { snprintf(url, sizeof url, "e%d", i); browser_visit(b, url); }
+    expect(b->cold && b->cold->count > 0, "a is in the cold tier before the restore");
+    uint32_t a_total = pred_total(&tm, "a"), e9_total = pred_total(&tm, "e9");
+    int64_t clock = b->clock;
+
+    expect(browser_restore_branch(b, 0) == 1, "restore succeeds");
+    expect(strcmp(b->current, "a") == 0 && b->current_ts == a_ts, "current is a, with its own stamp");
+    expect(browser_back_total(b) == 1 && b->back.size == 1 && strcmp(sp_at(&b->back, 0), "about:blank") == 0,
+           "back holds only about:blank");
+    expect(b->fwd.size == 2 && strcmp(sp_at(&b->fwd, 1), "b") == 0 && strcmp(sp_at(&b->fwd, 0), "c") == 0,
+           "forward walks b then c");
+    expect(b->nbranches == 1 && strcmp(b->branches[0]->at, "a") == 0 && b->branches[0]->pages.size == 11,
+           "the abandoned d, e0..e9 are archived off a");
+    expect(b->clock == clock, "no new stamp handed out");
+    expect(pred_total(&tm, "a") == a_total && pred_total(&tm, "e9") == e9_total, "no transition recorded");
+    expect(strcmp(browser_forward(b, 2), "c") == 0, "forward reaches c");
+    tm_destroy(&tm);
+}
+
+static void check_shared(void) {
+    const char *path = "bench_branches.json";
+    TabManager tm; tm_init(&tm, 50);
+    int id = tm_new_tab(&tm, "about:blank");
+    Browser *b = tm.tabs[id];
+    browser_visit(b, "a"); browser_visit(b, "b");
+    browser_back(b, 1);
+    browser_visit(b, "c");                 // archives [b] off a
+    tm_adopt_tab(&tm, browser_clone(b));
+    expect(save_session_json(path, &tm) == 1, "session saves");
+    tm_destroy(&tm);
+
+    FILE *f = fopen(path, "rb");
+    char text[4096]; size_t n = f ? fread(text, 1, sizeof text - 1, f) : 0;
+    if (f) fclose(f);
+    text[n] = '\0';
+    expect(strstr(text, "\"pages\"") && !strstr(strstr(text, "\"pages\"") + 1, "\"pages\""), "the branch is written once");
+
+    tm_init(&tm, 50);
+    expect(load_session_json(path, &tm, 50) == 1, "session loads");
+    expect(tm.count == 2 && tm.tabs[0]->nbranches == 1 && tm.tabs[1]->nbranches == 1, "both tabs keep the branch");
+    if (tm.count == 2 && tm.tabs[0]->nbranches == 1 && tm.tabs[1]->nbranches == 1) {
+        Branch *br = tm.tabs[0]->branches[0];
+        expect(br == tm.tabs[1]->branches[0] && br->refs == 2, "one branch, held by both");
+        expect(strcmp(br->at, "a") == 0 && br->pages.size == 1 && strcmp(sp_at(&br->pages, 0), "b") == 0, "it leads from a to b");
+    }
+    tm_destroy(&tm);
+    remove(path);
+}
+
+int main(void) {
+    printf("bench_branches: restore checks, then %d visit/back/visit/restore cycles\n", CYCLES);
+    check_restore();
+    check_shared();
+    if (fails) return 1;
+    printf("  checks            : ok\n");
+
+    TabManager tm; tm_init(&tm, 50);
+    int id = tm_new_tab(&tm, "about:blank");
+    Browser *b = tm.tabs[id];
+    char u[48], v[48];
+    double t0 = now_ms();
+    for (int i = 0; i < CYCLES; ++i) {
+        snprintf(u, sizeof u, "https://u.example/%d", i);
+        snprintf(v, sizeof v, "https://v.example/%d", i);
+        browser_visit(b, u);
+        browser_back(b, 1);
+        browser_visit(b, v);                          // archives [u]
+        browser_restore_branch(b, b->nbranches - 1);  // back to the point, [v] archived, [u] restored
+    }
+    double ms = now_ms() - t0;
+    printf("  cycle             : %8.1f ns (%d branches kept, %d predicted urls)\n", ms * 1e6 / CYCLES, b->nbranches, tm.pred.count);
+    tm_destroy(&tm);
+    return 0;
+}
@@ -0,0 +1,104 @@
+// bench/bench_history.c — per-entry heap strings (old Vec/Ring layout) vs StrPack
+//
+// Builds the same history for many tabs both ways. The heap strings are
+// allocated in shuffled (tab, entry) order so they scatter the way they do
+// after a long session of visits across tabs, then a full walk (print) and a
+// JSON escape pass (save_session_json) are timed over both layouts.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "vec.h"
+#include "strpack.h"
+#include "util.h"
+
+enum { TABS = 20000, DEPTH = 48, REPS = 5 };
+
+static double now_ms(void) {
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void make_url(char *out, size_t n, int tab, int j) {
+    snprintf(out, n, "https://www.example%d.com/path/%d/page-%d.html?q=%d", tab % 97, j % 13, j, tab);
+}
+
+// same escaping rules as session.c, into a reusable buffer
+static size_t escape_into(char *dst, const char *s) {
+    size_t k = 0; dst[k++] = '"';
+    for (const unsigned char *p=(const unsigned char*)s; *p; ++p) {
+        if (*p == '"' || *p == '\\') dst[k++] = '\\';
+        dst[k++] = (char)*p;
+    }
+    dst[k++] = '"';
+    return k;
+}
+
+int main(void) {
+    Vec *vs = (Vec*)malloc(sizeof(Vec) * TABS);
+    StrPack *ps = (StrPack*)malloc(sizeof(StrPack) * TABS);
+    char url[256];
+    for (int t = 0; t < TABS; ++t) { vec_init(&vs[t]); sp_init(&ps[t], SP_UNBOUNDED); }
+    for (int j = 0; j < DEPTH; ++j)
+        for (int t = 0; t < TABS; ++t) {
+            make_url(url, sizeof url, t, j);
+            sp_push(&ps[t], url);
+            vec_push(&vs[t], NULL);
+        }
+    // fill the Vec slots in a shuffled order (xorshift, fixed seed)
+    int *order = (int*)malloc(sizeof(int) * TABS * DEPTH);
+    for (int i = 0; i < TABS * DEPTH; ++i) order[i] = i;
+    unsigned x = 2463534242u;
+    for (int i = TABS * DEPTH - 1; i > 0; --i) {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        int k = (int)(x % (unsigned)(i + 1)), tmp = order[i]; order[i] = order[k]; order[k] = tmp;
+    }
+    for (int i = 0; i < TABS * DEPTH; ++i) {
+        int t = order[i] / DEPTH, j = order[i] % DEPTH;
+        vs[t].data[j] = sdup(sp_at(&ps[t], j));
+    }
+    free(order);
+
+    char *out = (char*)malloc(1 << 20);
+    double it_v = 1e30, it_p = 1e30, ser_v = 1e30, ser_p = 1e30;
+    unsigned long long sink = 0;
+
+    for (int r = 0; r < REPS; ++r) {
+        double t0 = now_ms();
+        for (int t = 0; t < TABS; ++t)
+            for (int j = 0; j < vs[t].size; ++j)
+                for (const char *p = vs[t].data[j]; *p; ++p) sink += (unsigned char)*p;
+        double t1 = now_ms();
+        for (int t = 0; t < TABS; ++t)
+            for (int j = 0; j < ps[t].size; ++j)
+                for (const char *p = sp_at(&ps[t], j); *p; ++p) sink += (unsigned char)*p;
+        double t2 = now_ms();
+        for (int t = 0; t < TABS; ++t) {
+            size_t k = 0;
+            for (int j = 0; j < vs[t].size; ++j) { k += escape_into(out + k, vs[t].data[j]); out[k++] = ','; }
+            sink += k;
+        }
+        double t3 = now_ms();
+        for (int t = 0; t < TABS; ++t) {
+            size_t k = 0;
+            for (int j = 0; j < ps[t].size; ++j) { k += escape_into(out + k, sp_at(&ps[t], j)); out[k++] = ','; }
+            sink += k;
+        }
+        double t4 = now_ms();
+        if (t1 - t0 < it_v) it_v = t1 - t0;
+        if (t2 - t1 < it_p) it_p = t2 - t1;
+        if (t3 - t2 < ser_v) ser_v = t3 - t2;
+        if (t4 - t3 < ser_p) ser_p = t4 - t3;
+    }
+
+    printf("bench_history: %d tabs x %d entries (best of %d)\n", TABS, DEPTH, REPS);
+    printf("  iterate   : heap strings %8.2f ms | strpack %8.2f ms | x%.2f\n", it_v, it_p, it_v / it_p);
+    printf("  serialize : heap strings %8.2f ms | strpack %8.2f ms | x%.2f\n", ser_v, ser_p, ser_v / ser_p);
+    printf("  (checksum %llu)\n", sink);
+
+    for (int t = 0; t < TABS; ++t) { vec_clear_free(&vs[t]); vec_free(&vs[t]); sp_free(&ps[t]); }
+    free(vs); free(ps); free(out);
+    return 0;
+}
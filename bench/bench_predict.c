@@ -0,0 +1,90 @@
+// bench/bench_predict.c — cost of the next-visit model
+//
+// Feeds a Zipf-ish stream of page-to-page transitions over a fixed set of
+// urls straight into a Predictor, then looks up every url's row. Update and
+// lookup should both stay flat as the number of distinct urls grows. Last,
+// the same stream visited in a tab under a memory budget, settled after
+// every visit as the command loop does: the model must stay inside it.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "predict.h"
+#include "features.h"
+
+enum { TRANSITIONS = 1000000 };
+
+static double now_ms(void) {
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static unsigned rng = 2463534242u;
+static unsigned xorshift(void) { rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5; return rng; }
+
+// roughly Zipf: small indices are much likelier
+static int pick(int n) {
+    double u = (xorshift() + 1.0) / 4294967297.0;
+    int i = (int)(n * u * u * u);
+    return i < n ? i : n - 1;
+}
+
+static void run(int nurls) {
+    char **urls = (char**)malloc((size_t)nurls * sizeof(char*));
+    for (int i = 0; i < nurls; ++i) {
+        urls[i] = (char*)malloc(48);
+        snprintf(urls[i], 48, "https://site%d.example/page/%d", i % 997, i);
+    }
+    int *seq = (int*)malloc((TRANSITIONS + 1) * sizeof(int));
+    for (int i = 0; i <= TRANSITIONS; ++i) seq[i] = pick(nurls);
+
+    Predictor p; pred_init(&p);
+    double t0 = now_ms();
+    for (int i = 0; i < TRANSITIONS; ++i) pred_visit(&p, urls[seq[i]], urls[seq[i + 1]], i);
+    double t1 = now_ms();
+    unsigned long hits = 0;
+    for (int i = 0; i < TRANSITIONS; ++i) {
+        const PredRow *r = pred_get(&p, urls[seq[i]]);
+        if (r && r->nnext) hits += r->next[0].n;
+    }
+    double t2 = now_ms();
+    printf("  %7d urls: %6.1f ns/update  %6.1f ns/lookup  (%d rows, %lu)\n", nurls,
+           (t1 - t0) * 1e6 / TRANSITIONS, (t2 - t1) * 1e6 / TRANSITIONS, p.count, hits);
+
+    pred_free(&p);
+    for (int i = 0; i < nurls; ++i) free(urls[i]);
+    free(urls); free(seq);
+}
+
+static void run_budget(int nurls, size_t limit) {
+    enum { VISITS = 200000 };
+    TabManager tm; tm_init(&tm, 5);
+    tm.mem.limit = limit;
+    int id = tm_new_tab(&tm, "about:blank");
+    Browser *b = tm.tabs[id];
+    char url[48];
+    size_t peak = 0;
+    double t0 = now_ms();
+    for (int i = 0; i < VISITS; ++i) {
+        int u = pick(nurls);
+        snprintf(url, sizeof url, "https://site%d.example/page/%d", u % 997, u);
+        browser_visit(b, url);
+        mem_settle(&tm, NULL);
+        if (mem_used(&tm) > peak) peak = mem_used(&tm);
+    }
+    double ms = now_ms() - t0;
+    printf("  %7d urls, limit %4zu KB: %6.1f ns/visit  peak %5zu KB  (%d rows, %ld urls forgotten)%s\n", nurls, limit >> 10,
+           ms * 1e6 / VISITS, peak >> 10, tm.pred.count, tm.mem.pred_dropped, limit && peak > limit ? "  over the limit: FAILED" : "");
+    tm_destroy(&tm);
+}
+
+int main(void) {
+    printf("bench_predict: %d transitions, top %d successors per url\n", TRANSITIONS, PRED_K);
+    run(1000);
+    run(50000);
+    run(500000);
+    run_budget(50000, 0);
+    run_budget(50000, 1 << 20);
+    return 0;
+}
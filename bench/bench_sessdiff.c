@@ -0,0 +1,98 @@
+// bench/bench_sessdiff.c — diffing two large sessions by tab id and content hash
+//
+// Two 50k-tab sessions that agree except for 1% of tabs browsed further,
+// 0.5% closed and 0.5% opened on one side. The same tab has the same tab_id
+// on both sides, as after a save and a load. Back is capped at 5 with no
+// spill dir, so the tabs browsed further have dropped their oldest page, and
+// three in four tabs start at about:blank: neither may throw the pairing
+// off. Hashing every tab is the floor; the diff with cold caches should sit
+// close to it. For contrast, matching tabs by comparing histories pairwise
+// is timed on a slice and scaled up.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sessdiff.h"
+
+enum { TABS = 50000, DEPTH = 8, BACK_CAP = 5, SLICE = 2000 };
+
+static double now_ms(void) {
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void build(TabManager *tm, int other) {
+    char url[128];
+    tm_init(tm, BACK_CAP);
+    tm->unindexed = 1;
+    for (int t = 0; t < TABS; ++t) {
+        if (other && t % 200 == 7) continue;                       // closed over there
+        snprintf(url, sizeof url, "https://tab%d.example.com/", t);
+        int id = tm_new_tab(tm, t % 4 ? "about:blank" : url);
+        tm->tabs[id]->tab_id = (uint64_t)t + 1;                    // the same tab on both sides
+        for (int j = 0; j < DEPTH; ++j) {
+            snprintf(url, sizeof url, "https://www.example%d.com/path/%d/page-%d.html", t % 97, j % 13, j);
+            browser_visit(tm->tabs[id], url);
+        }
+        if (other && t % 100 == 3) browser_visit(tm->tabs[id], "https://moved.on.example/");
+        if (other && t % 200 == 11) tm_new_tab(tm, "https://opened.there.example/");
+    }
+}
+
+static void invalidate(TabManager *tm) {
+    for (int i = 0; i < tm->count; ++i) tm->tabs[i]->version++;
+}
+
+static int same_history(const Browser *x, const Browser *y) {
+    if (strcmp(x->current, y->current) || x->back.size != y->back.size || x->fwd.size != y->fwd.size) return 0;
+    for (int i = 0; i < x->back.size; ++i) if (strcmp(sp_at(&x->back, i), sp_at(&y->back, i))) return 0;
+    for (int i = 0; i < x->fwd.size; ++i) if (strcmp(sp_at(&x->fwd, i), sp_at(&y->fwd, i))) return 0;
+    return 1;
+}
+
+int main(void) {
+    TabManager a, b;
+    build(&a, 0); build(&b, 1);
+
+    invalidate(&a); invalidate(&b);
+    double t0 = now_ms();
+    uint64_t sink = 0;
+    for (int i = 0; i < a.count; ++i) sink ^= browser_hash(a.tabs[i]);
+    for (int i = 0; i < b.count; ++i) sink ^= browser_hash(b.tabs[i]);
+    double hash_ms = now_ms() - t0;
+
+    SessionDiff d;
+    invalidate(&a); invalidate(&b);
+    t0 = now_ms();
+    session_diff(&a, &b, &d);
+    double cold_ms = now_ms() - t0;
+    session_diff_free(&d);
+
+    t0 = now_ms();
+    session_diff(&a, &b, &d);
+    double warm_ms = now_ms() - t0;
+
+    // pairwise: every tab of a slice against every tab of the same slice
+    t0 = now_ms();
+    int matched = 0;
+    for (int i = 0; i < SLICE; ++i)
+        for (int j = 0; j < SLICE; ++j)
+            if (same_history(a.tabs[i], b.tabs[j])) { matched++; break; }
+    double pair_ms = (now_ms() - t0) * ((double)TABS / SLICE) * ((double)TABS / SLICE);
+
+    printf("bench_sessdiff: %d vs %d tabs, %d pages each, back capped at %d (%llx)\n", a.count, b.count, DEPTH + 1, BACK_CAP,
+           (unsigned long long)(sink & 0xff));
+    printf("  hash both sides   : %8.2f ms\n", hash_ms);
+    printf("  diff, cold hashes : %8.2f ms\n", cold_ms);
+    printf("  diff, cached      : %8.2f ms\n", warm_ms);
+    printf("  pairwise (scaled) : %8.0f ms  (%d of %d matched in the slice)\n", pair_ms, matched, SLICE);
+    printf("  %d same, %d changed, %d only in a, %d only in b\n", d.nsame, d.nchanged, d.nonly_a, d.nonly_b);
+    int ok = d.nsame == TABS - TABS / 100 - TABS / 200 && d.nchanged == TABS / 100
+          && d.nonly_a == TABS / 200 && d.nonly_b == TABS / 200;
+    puts(ok ? "  counts ok" : "  counts WRONG");
+    session_diff_free(&d);
+    tm_destroy(&a); tm_destroy(&b);
+    return ok ? 0 : 1;
+}
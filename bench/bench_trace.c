@@ -0,0 +1,45 @@
+// bench/bench_trace.c — cost of the trace points on the hottest call
+//
+// browser_visit in a tight loop on one capped tab, best of several runs.
+// Build once plainly and once with make TRACE=1: the "off" line of the
+// traced build against the plain build is the cost of tracing compiled in
+// but disabled; the "on" line is the cost of recording every call.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "browser.h"
+#include "trace.h"
+
+enum { VISITS = 2000000, RUNS = 5 };
+
+static double now_ms(void) {
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static double best_ns_per_visit(void) {
+    static const char *urls[4] = { "https://a.example/x", "https://b.example/y/z", "https://c.example/", "https://d.example/q?r=1" };
+    double best = 1e30;
+    for (int r = 0; r < RUNS; ++r) {
+        Browser b; browser_init(&b, "about:blank", 50);
+        double t0 = now_ms();
+        for (int i = 0; i < VISITS; ++i) browser_visit(&b, urls[i & 3]);
+        double ns = (now_ms() - t0) * 1e6 / VISITS;
+        if (ns < best) best = ns;
+        browser_destroy(&b);
+    }
+    return best;
+}
+
+int main(void) {
+    printf("bench_trace: %d visits x %d runs, tracing %s\n", VISITS, RUNS, trace_available() ? "compiled in" : "compiled out");
+    printf("  tracing off : %7.2f ns/visit\n", best_ns_per_visit());
+    if (trace_available()) {
+        trace_set(1);
+        printf("  tracing on  : %7.2f ns/visit\n", best_ns_per_visit());
+        trace_set(0);
+    }
+    return 0;
+}
@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "batch.h"
+#include "commands.h"
+#include "features.h"   // autosave_final
+#include "session.h"
+#include "util.h"
+#include "vec.h"
+#include "trace.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+  #include <windows.h>
+  #include <process.h>     // _beginthreadex
+  typedef CRITICAL_SECTION Lock;
+  #define lock_init(l)     InitializeCriticalSection(l)
+  #define lock_free(l)     DeleteCriticalSection(l)
+  #define lock_take(l)     EnterCriticalSection(l)
+  #define lock_give(l)     LeaveCriticalSection(l)
+#else
+  #include <dirent.h>
+  #include <pthread.h>
+  #include <unistd.h>      // sysconf
+  typedef pthread_mutex_t Lock;
+  #define lock_init(l)     pthread_mutex_init(l, NULL)
+  #define lock_free(l)     pthread_mutex_destroy(l)
+  #define lock_take(l)     pthread_mutex_lock(l)
+  #define lock_give(l)     pthread_mutex_unlock(l)
+#endif
+
+// Scripts [lo, hi) still queued on one worker. The owner takes from lo, a
+// thief takes the upper half, so the two rarely want the same end. Scripts
+// are coarse (whole sessions), so a lock per queue is not the bottleneck.
+typedef struct {
+    Lock lock;
+    int lo, hi;
+} Queue;
+
+typedef struct Pool Pool;
+
+typedef struct {
+    Pool *pool;
+    int self;
+    long commands;
+    int failed, steals;
+} Worker;
+
+struct Pool {
+    const BatchOpts *o;
+    char **names;
+    int nworkers;
+    Queue *q;
+    Worker *w;
+};
+
+static int ends_with(const char *s, const char *suf) {
+    size_t n = strlen(s), k = strlen(suf);
+    return n >= k && strcmp(s + n - k, suf) == 0;
+}
+
+static int by_name(const void *a, const void *b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// *.txt names in dir, sorted so runs are reproducible; -1 if dir is unreadable
+static int list_scripts(const char *dir, char ***out) {
+    Vec v; vec_init(&v);
+#if defined(_WIN32) || defined(_WIN64)
+    char pat[400]; snprintf(pat, sizeof pat, "%s\\*.txt", dir);
+    WIN32_FIND_DATAA fd;
+    HANDLE h = FindFirstFileA(pat, &fd);
+    if (h == INVALID_HANDLE_VALUE) { vec_free(&v); *out = NULL; return GetLastError() == ERROR_FILE_NOT_FOUND ? 0 : -1; }
+    do if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && ends_with(fd.cFileName, ".txt")) vec_push(&v, sdup(fd.cFileName));
+    while (FindNextFileA(h, &fd));
+    FindClose(h);
+#else
+    DIR *d = opendir(dir);
+    if (!d) { vec_free(&v); *out = NULL; return -1; }
+    for (struct dirent *e; (e = readdir(d)); )
+        if (e->d_name[0] != '.' && ends_with(e->d_name, ".txt")) vec_push(&v, sdup(e->d_name));
+    closedir(d);
+#endif
+    qsort(v.data, (size_t)v.size, sizeof(char*), by_name);
+    *out = (char**)v.data;
+    return v.size;
+}
+
+// one script, start to finish, on the calling thread
+static void run_script(Worker *w, const char *name) {
+    const BatchOpts *o = w->pool->o;
+    const char *od = o->out_dir ? o->out_dir : o->dir;
+    size_t stem = strlen(name) - 4;   // without ".txt"
+    char path[600], opath[600], spath[600];
+    snprintf(path, sizeof path, "%s/%s", o->dir, name);
+    snprintf(opath, sizeof opath, "%s/%.*s.out", od, (int)stem, name);
+    snprintf(spath, sizeof spath, "%s/%.*s.session.json", od, (int)stem, name);
+
+    TRACE_BEGIN(span, "batch_script");
+    FILE *in = fopen(path, "rb");
+    FILE *out = in ? fopen(opath, "wb") : NULL;
+    if (!out) {
+        fprintf(stderr, "batch: cannot %s %s\n", in ? "write" : "open", in ? opath : path);
+        if (in) fclose(in);
+        w->failed++;
+        TRACE_END_ARG(span, name);
+        return;
+    }
+    setvbuf(out, NULL, _IOFBF, 1 << 16);
+
+    TabManager tm; tm_init(&tm, o->back_cap);
+    if (o->spill_dir) tm_set_spill_dir(&tm, o->spill_dir);
+    tm.mem.limit = o->mem_limit;
+    UndoStack undo; undo_init(&undo);
+    tm_new_tab(&tm, "about:blank");
+
+    char line[4096];
+    while (fgets(line, sizeof line, in)) {
+        w->commands++;
+        if (!process_command(&tm, &undo, line, out)) break;
+    }
+    fclose(in);
+    autosave_final(&tm);
+    int ok = save_session_json(spath, &tm);
+    if (fclose(out) != 0) ok = 0;
+    if (!ok) { fprintf(stderr, "batch: cannot write results of %s\n", name); w->failed++; }
+
+    tm_destroy(&tm);
+    undo_destroy(&undo);
+    TRACE_END_ARG(span, name);
+}
+
+// the next script for worker w: its own queue first, then half of a neighbour's
+static int next_script(Worker *w) {
+    Pool *p = w->pool;
+    Queue *mine = &p->q[w->self];
+    int job = -1;
+    lock_take(&mine->lock);
+    if (mine->lo < mine->hi) job = mine->lo++;
+    lock_give(&mine->lock);
+    if (job >= 0) return job;
+
+    for (int k = 1; k < p->nworkers; ++k) {
+        Queue *v = &p->q[(w->self + k) % p->nworkers];
+        int lo = 0, hi = 0;
+        lock_take(&v->lock);
+        if (v->lo < v->hi) {
+            int n = (v->hi - v->lo + 1) / 2;
+            hi = v->hi; lo = hi - n; v->hi = lo;
+        }
+        lock_give(&v->lock);
+        if (lo == hi) continue;
+        // run the first stolen script now, queue the rest where others can steal them
+        lock_take(&mine->lock);
+        mine->lo = lo + 1; mine->hi = hi;
+        lock_give(&mine->lock);
+        w->steals++;
+        return lo;
+    }
+    return -1;   // nothing queued anywhere; no script adds work, so we are done
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+static unsigned __stdcall worker_main(void *arg)
+#else
+static void *worker_main(void *arg)
+#endif
+{
+    Worker *w = (Worker*)arg;
+    for (int job; (job = next_script(w)) >= 0; )
+        run_script(w, w->pool->names[job]);
+    return 0;
+}
+
+int batch_default_threads(void) {
+#if defined(_WIN32) || defined(_WIN64)
+    SYSTEM_INFO si; GetSystemInfo(&si);
+    return si.dwNumberOfProcessors > 0 ? (int)si.dwNumberOfProcessors : 1;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#else
+    return 1;
+#endif
+}
+
+static double secs_now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int batch_run(const BatchOpts *o, BatchStats *st) {
+    memset(st, 0, sizeof *st);
+    Pool p; memset(&p, 0, sizeof p);
+    p.o = o;
+    int n = list_scripts(o->dir, &p.names);
+    if (n < 0) return -1;
+    double t0 = secs_now();
+
+    p.nworkers = o->threads > 0 ? o->threads : batch_default_threads();
+    if (p.nworkers > n) p.nworkers = n ? n : 1;
+    p.q = (Queue*)calloc((size_t)p.nworkers, sizeof(Queue));
+    p.w = (Worker*)calloc((size_t)p.nworkers, sizeof(Worker));
+    for (int i = 0; i < p.nworkers; ++i) {
+        lock_init(&p.q[i].lock);
+        p.q[i].lo = (int)((long)n * i / p.nworkers);
+        p.q[i].hi = (int)((long)n * (i + 1) / p.nworkers);
+        p.w[i].pool = &p; p.w[i].self = i;
+    }
+
+    // the calling thread is worker 0; a worker that fails to start leaves
+    // its queue to be stolen
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE *th = (HANDLE*)calloc((size_t)p.nworkers, sizeof(HANDLE));
+    for (int i = 1; i < p.nworkers; ++i) th[i] = (HANDLE)_beginthreadex(NULL, 0, worker_main, &p.w[i], 0, NULL);
+    worker_main(&p.w[0]);
+    for (int i = 1; i < p.nworkers; ++i) if (th[i]) { WaitForSingleObject(th[i], INFINITE); CloseHandle(th[i]); }
+#else
+    pthread_t *th = (pthread_t*)calloc((size_t)p.nworkers, sizeof(pthread_t));
+    char *up = (char*)calloc((size_t)p.nworkers, 1);
+    for (int i = 1; i < p.nworkers; ++i) up[i] = pthread_create(&th[i], NULL, worker_main, &p.w[i]) == 0;
+    worker_main(&p.w[0]);
+    for (int i = 1; i < p.nworkers; ++i) if (up[i]) pthread_join(th[i], NULL);
+    free(up);
+#endif
+    free(th);
+
+    st->scripts = n;
+    st->threads = p.nworkers;
+    for (int i = 0; i < p.nworkers; ++i) {
+        st->commands += p.w[i].commands;
+        st->failed += p.w[i].failed;
+        st->steals += p.w[i].steals;
+        lock_free(&p.q[i].lock);
+    }
+    st->secs = secs_now() - t0;
+    for (int i = 0; i < n; ++i) free(p.names[i]);
+    free(p.names); free(p.q); free(p.w);
+    return 0;
+}
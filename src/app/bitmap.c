@@ -0,0 +1,263 @@
+#include <stdlib.h>
+#include <string.h>
+#include "bitmap.h"
+
+#define ARR_MAX 4096
+#define WORDS   1024
+
+static int popcnt64(uint64_t x){
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);
+#else
+    int n = 0; while (x) { x &= x - 1; ++n; } return n;
+#endif
+}
+
+static int ctz64(uint64_t x){
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    int n = 0; while (!(x & 1)) { x >>= 1; ++n; } return n;
+#endif
+}
+
+// ---- containers ----
+static void rc_free(RCont *c){ free(c->arr); free(c->bits); c->arr = NULL; c->bits = NULL; c->card = c->cap = 0; }
+
+static int rc_has(const RCont *c, uint16_t v){
+    if (c->bits) return (int)((c->bits[v >> 6] >> (v & 63)) & 1);
+    int lo = 0, hi = c->card - 1;
+    while (lo <= hi){ int m = (lo + hi) >> 1; if (c->arr[m] == v) return 1; if (c->arr[m] < v) lo = m + 1; else hi = m - 1; }
+    return 0;
+}
+
+static void rc_to_bits(RCont *c){
+    uint64_t *w = (uint64_t*)calloc(WORDS, sizeof(uint64_t));
+    for (int i=0;i<c->card;++i) w[c->arr[i] >> 6] |= 1ULL << (c->arr[i] & 63);
+    free(c->arr); c->arr = NULL; c->cap = 0; c->bits = w;
+}
+
+// dense container with few ids left goes back to an array; card must be current
+static void rc_normalize(RCont *c){
+    if (!c->bits || c->card > ARR_MAX) return;
+    uint16_t *a = (uint16_t*)malloc((size_t)(c->card ? c->card : 1) * sizeof(uint16_t));
+    int k = 0;
+    for (int w=0; w<WORDS; ++w)
+        for (uint64_t x = c->bits[w]; x; x &= x - 1) a[k++] = (uint16_t)(w * 64 + ctz64(x));
+    free(c->bits); c->bits = NULL; c->arr = a; c->cap = c->card ? c->card : 1;
+}
+
+static void rc_add(RCont *c, uint16_t v){
+    if (c->bits){
+        uint64_t m = 1ULL << (v & 63);
+        if (!(c->bits[v >> 6] & m)){ c->bits[v >> 6] |= m; c->card++; }
+        return;
+    }
+    int lo = 0, hi = c->card;
+    while (lo < hi){ int m = (lo + hi) >> 1; if (c->arr[m] < v) lo = m + 1; else hi = m; }
+    if (lo < c->card && c->arr[lo] == v) return;
+    if (c->card == ARR_MAX){ rc_to_bits(c); rc_add(c, v); return; }
+    if (c->card == c->cap){ c->cap = c->cap ? c->cap * 2 : 4; c->arr = (uint16_t*)realloc(c->arr, (size_t)c->cap * sizeof(uint16_t)); }
+    memmove(c->arr + lo + 1, c->arr + lo, (size_t)(c->card - lo) * sizeof(uint16_t));
+    c->arr[lo] = v; c->card++;
+}
+
+static void rc_remove(RCont *c, uint16_t v){
+    if (c->bits){
+        uint64_t m = 1ULL << (v & 63);
+        if (c->bits[v >> 6] & m){ c->bits[v >> 6] &= ~m; c->card--; rc_normalize(c); }
+        return;
+    }
+    int lo = 0, hi = c->card;
+    while (lo < hi){ int m = (lo + hi) >> 1; if (c->arr[m] < v) lo = m + 1; else hi = m; }
+    if (lo == c->card || c->arr[lo] != v) return;
+    memmove(c->arr + lo, c->arr + lo + 1, (size_t)(c->card - lo - 1) * sizeof(uint16_t));
+    c->card--;
+}
+
+static void rc_copy(RCont *d, const RCont *s){
+    *d = *s;
+    if (s->bits){ d->bits = (uint64_t*)malloc(WORDS * sizeof(uint64_t)); memcpy(d->bits, s->bits, WORDS * sizeof(uint64_t)); }
+    else { d->cap = s->card ? s->card : 1; d->arr = (uint16_t*)malloc((size_t)d->cap * sizeof(uint16_t)); memcpy(d->arr, s->arr, (size_t)s->card * sizeof(uint16_t)); }
+}
+
+static void rc_and(RCont *d, const RCont *a, const RCont *b){
+    d->key = a->key; d->arr = NULL; d->bits = NULL; d->card = d->cap = 0;
+    if (a->bits && b->bits){
+        d->bits = (uint64_t*)malloc(WORDS * sizeof(uint64_t));
+        for (int w=0; w<WORDS; ++w){ d->bits[w] = a->bits[w] & b->bits[w]; d->card += popcnt64(d->bits[w]); }
+        rc_normalize(d);
+        return;
+    }
+    if (a->bits){ const RCont *t = a; a = b; b = t; }   // a is now an array
+    d->cap = a->card ? a->card : 1;
+    d->arr = (uint16_t*)malloc((size_t)d->cap * sizeof(uint16_t));
+    if (!b->bits){   // merge two sorted arrays
+        int i = 0, j = 0;
+        while (i < a->card && j < b->card){
+            if (a->arr[i] < b->arr[j]) ++i; else if (a->arr[i] > b->arr[j]) ++j;
+            else { d->arr[d->card++] = a->arr[i]; ++i; ++j; }
+        }
+    } else {
+        for (int i=0;i<a->card;++i) if (rc_has(b, a->arr[i])) d->arr[d->card++] = a->arr[i];
+    }
+}
+
+static void rc_or(RCont *d, const RCont *a, const RCont *b){
+    d->key = a->key; d->arr = NULL; d->bits = NULL; d->card = d->cap = 0;
+    if (!a->bits && !b->bits && a->card + b->card <= ARR_MAX){
+        d->cap = a->card + b->card ? a->card + b->card : 1;
+        d->arr = (uint16_t*)malloc((size_t)d->cap * sizeof(uint16_t));
+        int i = 0, j = 0;
+        while (i < a->card || j < b->card){
+            if (j == b->card || (i < a->card && a->arr[i] < b->arr[j])) d->arr[d->card++] = a->arr[i++];
+            else if (i == a->card || b->arr[j] < a->arr[i]) d->arr[d->card++] = b->arr[j++];
+            else { d->arr[d->card++] = a->arr[i]; ++i; ++j; }
+        }
+        return;
+    }
+    d->bits = (uint64_t*)calloc(WORDS, sizeof(uint64_t));
+    const RCont *src[2] = { a, b };
+    for (int s=0; s<2; ++s){
+        if (src[s]->bits) for (int w=0; w<WORDS; ++w) d->bits[w] |= src[s]->bits[w];
+        else for (int i=0;i<src[s]->card;++i) d->bits[src[s]->arr[i] >> 6] |= 1ULL << (src[s]->arr[i] & 63);
+    }
+    for (int w=0; w<WORDS; ++w) d->card += popcnt64(d->bits[w]);
+    rc_normalize(d);
+}
+
+static void rc_andnot(RCont *d, const RCont *a, const RCont *b){
+    if (!a->bits){
+        d->key = a->key; d->bits = NULL; d->card = 0; d->cap = a->card ? a->card : 1;
+        d->arr = (uint16_t*)malloc((size_t)d->cap * sizeof(uint16_t));
+        for (int i=0;i<a->card;++i) if (!rc_has(b, a->arr[i])) d->arr[d->card++] = a->arr[i];
+        return;
+    }
+    rc_copy(d, a);
+    if (b->bits) for (int w=0; w<WORDS; ++w) d->bits[w] &= ~b->bits[w];
+    else for (int i=0;i<b->card;++i) d->bits[b->arr[i] >> 6] &= ~(1ULL << (b->arr[i] & 63));
+    d->card = 0;
+    for (int w=0; w<WORDS; ++w) d->card += popcnt64(d->bits[w]);
+    rc_normalize(d);
+}
+
+// ---- bitmap ----
+void bmp_init(Bitmap *b){ b->c = NULL; b->n = b->cap = 0; }
+
+void bmp_free(Bitmap *b){
+    for (int i=0;i<b->n;++i) rc_free(&b->c[i]);
+    free(b->c); bmp_init(b);
+}
+
+static int bmp_find(const Bitmap *b, uint16_t key, int *at){
+    int lo = 0, hi = b->n;
+    while (lo < hi){ int m = (lo + hi) >> 1; if (b->c[m].key < key) lo = m + 1; else hi = m; }
+    *at = lo;
+    return lo < b->n && b->c[lo].key == key;
+}
+
+static RCont *bmp_push(Bitmap *b){
+    if (b->n == b->cap){ b->cap = b->cap ? b->cap * 2 : 4; b->c = (RCont*)realloc(b->c, (size_t)b->cap * sizeof(RCont)); }
+    return &b->c[b->n++];
+}
+
+void bmp_add(Bitmap *b, uint32_t x){
+    int at;
+    if (!bmp_find(b, (uint16_t)(x >> 16), &at)){
+        bmp_push(b);
+        memmove(&b->c[at + 1], &b->c[at], (size_t)(b->n - 1 - at) * sizeof(RCont));
+        RCont *c = &b->c[at];
+        c->key = (uint16_t)(x >> 16); c->card = c->cap = 0; c->arr = NULL; c->bits = NULL;
+    }
+    rc_add(&b->c[at], (uint16_t)x);
+}
+
+void bmp_remove(Bitmap *b, uint32_t x){
+    int at;
+    if (!bmp_find(b, (uint16_t)(x >> 16), &at)) return;
+    rc_remove(&b->c[at], (uint16_t)x);
+    if (b->c[at].card) return;
+    rc_free(&b->c[at]);
+    memmove(&b->c[at], &b->c[at + 1], (size_t)(b->n - at - 1) * sizeof(RCont));
+    b->n--;
+}
+
+int bmp_contains(const Bitmap *b, uint32_t x){
+    int at;
+    return bmp_find(b, (uint16_t)(x >> 16), &at) && rc_has(&b->c[at], (uint16_t)x);
+}
+
+uint32_t bmp_count(const Bitmap *b){
+    uint32_t n = 0;
+    for (int i=0;i<b->n;++i) n += (uint32_t)b->c[i].card;
+    return n;
+}
+
+void bmp_fill(Bitmap *b, uint32_t n){
+    bmp_free(b);
+    for (uint32_t base = 0; base < n; base += 65536){
+        uint32_t k = n - base < 65536 ? n - base : 65536;
+        RCont *c = bmp_push(b);
+        c->key = (uint16_t)(base >> 16); c->card = (int)k; c->cap = 0; c->arr = NULL;
+        c->bits = (uint64_t*)calloc(WORDS, sizeof(uint64_t));
+        for (uint32_t w = 0; w < k / 64; ++w) c->bits[w] = ~0ULL;
+        if (k % 64) c->bits[k / 64] = (1ULL << (k % 64)) - 1;
+        rc_normalize(c);
+    }
+}
+
+void bmp_copy(Bitmap *dst, const Bitmap *src){
+    bmp_free(dst);
+    for (int i=0;i<src->n;++i) rc_copy(bmp_push(dst), &src->c[i]);
+}
+
+// keep the container only if the op left something in it
+static void bmp_keep(Bitmap *out){
+    if (out->c[out->n - 1].card == 0){ rc_free(&out->c[out->n - 1]); out->n--; }
+}
+
+void bmp_and(Bitmap *out, const Bitmap *a, const Bitmap *b){
+    bmp_free(out);
+    int i = 0, j = 0;
+    while (i < a->n && j < b->n){
+        if (a->c[i].key < b->c[j].key) ++i;
+        else if (a->c[i].key > b->c[j].key) ++j;
+        else { rc_and(bmp_push(out), &a->c[i], &b->c[j]); bmp_keep(out); ++i; ++j; }
+    }
+}
+
+void bmp_or(Bitmap *out, const Bitmap *a, const Bitmap *b){
+    bmp_free(out);
+    int i = 0, j = 0;
+    while (i < a->n || j < b->n){
+        if (j == b->n || (i < a->n && a->c[i].key < b->c[j].key)) rc_copy(bmp_push(out), &a->c[i++]);
+        else if (i == a->n || b->c[j].key < a->c[i].key) rc_copy(bmp_push(out), &b->c[j++]);
+        else { rc_or(bmp_push(out), &a->c[i], &b->c[j]); ++i; ++j; }
+    }
+}
+
+void bmp_andnot(Bitmap *out, const Bitmap *a, const Bitmap *b){
+    bmp_free(out);
+    int j = 0;
+    for (int i=0;i<a->n;++i){
+        while (j < b->n && b->c[j].key < a->c[i].key) ++j;
+        if (j < b->n && b->c[j].key == a->c[i].key) { rc_andnot(bmp_push(out), &a->c[i], &b->c[j]); bmp_keep(out); }
+        else rc_copy(bmp_push(out), &a->c[i]);
+    }
+}
+
+uint32_t bmp_to_array(const Bitmap *b, uint32_t **out){
+    uint32_t n = bmp_count(b), k = 0;
+    *out = (uint32_t*)malloc((size_t)(n ? n : 1) * sizeof(uint32_t));
+    for (int i=0;i<b->n;++i){
+        const RCont *c = &b->c[i];
+        uint32_t hi = (uint32_t)c->key << 16;
+        if (c->bits){
+            for (int w=0; w<WORDS; ++w)
+                for (uint64_t x = c->bits[w]; x; x &= x - 1) (*out)[k++] = hi | (uint32_t)(w * 64 + ctz64(x));
+        } else {
+            for (int j=0;j<c->card;++j) (*out)[k++] = hi | c->arr[j];
+        }
+    }
+    return n;
+}
@@ -0,0 +1,448 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/stat.h>
+#include "bmimport.h"
+
+#define IMPORT_CHUNK (64 * 1024)
+
+typedef struct { char *p; size_t n, cap; } Buf;
+
+static void buf_put(Buf *b, char c){
+    if (b->n + 2 > b->cap){ b->cap = b->cap ? b->cap * 2 : 64; b->p = (char*)realloc(b->p, b->cap); }
+    b->p[b->n++] = c; b->p[b->n] = '\0';
+}
+static void buf_add(Buf *b, const char *s, size_t n){
+    if (b->n + n + 1 > b->cap){ while (b->n + n + 1 > b->cap) b->cap = b->cap ? b->cap * 2 : 64; b->p = (char*)realloc(b->p, b->cap); }
+    memcpy(b->p + b->n, s, n); b->n += n; b->p[b->n] = '\0';
+}
+static void buf_puts(Buf *b, const char *s){ buf_add(b, s, strlen(s)); }
+static void buf_reset(Buf *b){ b->n = 0; if (b->p) b->p[0] = '\0'; }
+static char *buf_finish(Buf *b){ return b->p ? b->p : sdup(""); }   // hands the bytes over
+
+static void utf8_put(Buf *b, unsigned cp){
+    if (cp < 0x80) buf_put(b, (char)cp);
+    else if (cp < 0x800){ buf_put(b, (char)(0xC0 | cp >> 6)); buf_put(b, (char)(0x80 | (cp & 0x3F))); }
+    else if (cp < 0x10000){ buf_put(b, (char)(0xE0 | cp >> 12)); buf_put(b, (char)(0x80 | (cp >> 6 & 0x3F))); buf_put(b, (char)(0x80 | (cp & 0x3F))); }
+    else { buf_put(b, (char)(0xF0 | cp >> 18)); buf_put(b, (char)(0x80 | (cp >> 12 & 0x3F))); buf_put(b, (char)(0x80 | (cp >> 6 & 0x3F))); buf_put(b, (char)(0x80 | (cp & 0x3F))); }
+}
+
+enum { FMT_UNKNOWN, FMT_HTML, FMT_JSON };
+enum { H_TEXT, H_TAG };
+enum { CAP_NONE, CAP_LINK, CAP_FOLDER };
+enum { J_VALUE, J_STRING, J_ESC, J_UESC, J_SCALAR };
+enum { K_NONE, K_NAME, K_URL, K_FOLDER, K_TAGS, K_CHILDREN };
+
+typedef struct {
+    char kind;                 // '{' or '['
+    int  key, want_key;        // member being read (objects only)
+    int  is_folder;            // had a "children" array
+    int  folder_at;            // innermost folder node around (or of) this object, -1 none
+    char *name, *url, *folder;
+    Buf  tags;                 // comma-joined
+    int  first;                // bm->size when the object opened
+} JFrame;
+
+// A folder's name may come after its children (Chrome writes "children"
+// before "name"), so items point at a node and paths are joined on close.
+typedef struct {
+    char *name;                // NULL until known, or for an untitled folder
+    int parent;                // node index, -1 at the top
+    char *path;                // resolved on close
+} JFolder;
+
+struct BMImport {
+    BMList *bm; BMAddFn add; void *ctx;
+    int fmt, bad, added, base;
+    Buf tok;                   // tag text or string being assembled
+    // Netscape HTML
+    int hstate, capture; char quote;
+    Buf text;
+    char *href, *tags, *pending_folder;
+    char **fstack; int fdepth, fcap;
+    Buf path;                  // fstack joined with '/', kept current on push/pop
+    // JSON
+    int jstate, ucount; unsigned uacc, uhigh;
+    JFrame *fr; int nfr, cfr;
+    JFolder *fold; int nfold, cfold;   // every folder met, parents before children
+    int *pend; int npend, cpend;       // folder node per imported item (-1 none), applied on close
+};
+
+BMImport *bmi_open(BMList *bm, BMAddFn add, void *ctx){
+    BMImport *im = (BMImport*)calloc(1, sizeof(BMImport));
+    im->bm = bm; im->add = add; im->ctx = ctx;
+    im->base = bm->size;
+    return im;
+}
+
+// ---- shared ----
+static void add_tags(BMImport *im, int idx, const char *list){
+    if (!list) return;
+    Buf t = {0};
+    for (const char *p = list; ; ++p){
+        if (*p == ',' || !*p){
+            size_t a = 0, e = t.n;
+            while (a < e && isspace((unsigned char)t.p[a])) a++;
+            while (e > a && isspace((unsigned char)t.p[e-1])) e--;
+            if (e > a){ t.p[e] = '\0'; bm_tag(im->bm, idx, t.p + a); }
+            buf_reset(&t);
+            if (!*p) break;
+        } else buf_put(&t, *p);
+    }
+    free(t.p);
+}
+
+static int emit(BMImport *im, const char *name, const char *url){
+    int idx = im->add(im->ctx, name && *name ? name : url, url);
+    im->added++;
+    return idx;
+}
+
+// ---- Netscape HTML ----
+static void html_decode(Buf *out, const char *s, size_t n){
+    static const struct { const char *ent; char c; } named[] = {
+        {"amp;",'&'}, {"lt;",'<'}, {"gt;",'>'}, {"quot;",'"'}, {"apos;",'\''}, {"nbsp;",' '} };
+    buf_reset(out);
+    for (size_t i = 0; i < n; ++i){
+        if (s[i] != '&'){ buf_put(out, s[i]); continue; }
+        size_t k, rest = n - i - 1;
+        for (k = 0; k < sizeof named / sizeof named[0]; ++k){
+            size_t L = strlen(named[k].ent);
+            if (rest >= L && strncmp(s + i + 1, named[k].ent, L) == 0){ buf_put(out, named[k].c); i += L; break; }
+        }
+        if (k < sizeof named / sizeof named[0]) continue;
+        if (rest >= 2 && s[i+1] == '#'){
+            size_t j = i + 2; int hex = j < n && (s[j] == 'x' || s[j] == 'X'); if (hex) j++;
+            unsigned cp = 0; size_t d0 = j;
+            while (j < n && (hex ? isxdigit((unsigned char)s[j]) : isdigit((unsigned char)s[j]))){
+                cp = cp * (hex ? 16u : 10u) + (unsigned)(isdigit((unsigned char)s[j]) ? s[j]-'0' : (tolower((unsigned char)s[j])-'a'+10));
+                j++;
+            }
+            if (j > d0 && j < n && s[j] == ';' && cp && cp < 0x110000){ utf8_put(out, cp); i = j; continue; }
+        }
+        buf_put(out, '&');
+    }
+    // trim
+    size_t a = 0, e = out->n;
+    while (a < e && isspace((unsigned char)out->p[a])) a++;
+    while (e > a && isspace((unsigned char)out->p[e-1])) e--;
+    if (a || e < out->n){ memmove(out->p, out->p + a, e - a); out->n = e - a; out->p[out->n] = '\0'; }
+}
+
+// value of attribute `want` in the tag text, entity-decoded; NULL if absent
+static char *html_attr(const char *t, const char *want){
+    const char *p = t;
+    while (*p && !isspace((unsigned char)*p)) p++;   // tag name
+    size_t wl = strlen(want);
+    for (;;){
+        while (isspace((unsigned char)*p)) p++;
+        if (!*p || *p == '/') return NULL;
+        const char *an = p;
+        while (*p && *p != '=' && !isspace((unsigned char)*p)) p++;
+        size_t al = (size_t)(p - an);
+        while (isspace((unsigned char)*p)) p++;
+        const char *v = p, *ve = p;
+        if (*p == '='){
+            p++; while (isspace((unsigned char)*p)) p++;
+            if (*p == '"' || *p == '\''){ char q = *p++; v = p; while (*p && *p != q) p++; ve = p; if (*p) p++; }
+            else { v = p; while (*p && !isspace((unsigned char)*p)) p++; ve = p; }
+        }
+        size_t k = 0;
+        while (k < wl && k < al && tolower((unsigned char)an[k]) == want[k]) k++;
+        if (k == wl && al == wl){
+            Buf out = {0};
+            html_decode(&out, v, (size_t)(ve - v));
+            return buf_finish(&out);
+        }
+    }
+}
+
+static void html_folder_path(BMImport *im){
+    Buf *out = &im->path;
+    buf_reset(out);
+    for (int i = 0; i < im->fdepth; ++i){
+        if (!im->fstack[i]) continue;
+        if (out->n) buf_put(out, '/');
+        buf_puts(out, im->fstack[i]);
+    }
+}
+
+static void html_tag(BMImport *im){
+    const char *t = im->tok.n ? im->tok.p : "";
+    char name[8]; size_t k = 0;
+    while (t[k] && !isspace((unsigned char)t[k]) && t[k] != '>' && k < sizeof name - 1){ name[k] = (char)tolower((unsigned char)t[k]); k++; }
+    name[k] = '\0';
+    if (strcmp(name, "a") == 0){
+        free(im->href); free(im->tags);
+        im->href = html_attr(t, "href"); im->tags = html_attr(t, "tags");
+        im->capture = CAP_LINK; buf_reset(&im->text);
+    } else if (strcmp(name, "/a") == 0 && im->capture == CAP_LINK){
+        if (im->href && *im->href && strncmp(im->href, "place:", 6) != 0){
+            Buf title = {0};
+            html_decode(&title, im->text.p ? im->text.p : "", im->text.n);
+            int idx = emit(im, title.p, im->href);
+            if (im->path.n) bm_set_folder(im->bm, idx, im->path.p);
+            add_tags(im, idx, im->tags);
+            free(title.p);
+        }
+        im->capture = CAP_NONE;
+    } else if (strcmp(name, "h3") == 0){
+        im->capture = CAP_FOLDER; buf_reset(&im->text);
+    } else if (strcmp(name, "/h3") == 0 && im->capture == CAP_FOLDER){
+        Buf title = {0};
+        html_decode(&title, im->text.p ? im->text.p : "", im->text.n);
+        free(im->pending_folder); im->pending_folder = buf_finish(&title);
+        im->capture = CAP_NONE;
+    } else if (strcmp(name, "dl") == 0){
+        if (im->fdepth == im->fcap){ im->fcap = im->fcap ? im->fcap * 2 : 8; im->fstack = (char**)realloc(im->fstack, (size_t)im->fcap * sizeof(char*)); }
+        if (im->pending_folder && !*im->pending_folder){ free(im->pending_folder); im->pending_folder = NULL; }
+        im->fstack[im->fdepth++] = im->pending_folder;   // NULL for an untitled list
+        im->pending_folder = NULL;
+        html_folder_path(im);
+    } else if (strcmp(name, "/dl") == 0 && im->fdepth > 0){
+        free(im->fstack[--im->fdepth]);
+        html_folder_path(im);
+    }
+}
+
+// spans between markup bytes are located with memchr and copied whole
+static void html_feed(BMImport *im, const char *p, size_t n){
+    const char *end = p + n;
+    while (p < end){
+        if (im->hstate == H_TEXT){
+            const char *lt = (const char*)memchr(p, '<', (size_t)(end - p));
+            const char *stop = lt ? lt : end;
+            if (im->capture) buf_add(&im->text, p, (size_t)(stop - p));
+            if (!lt) return;
+            im->hstate = H_TAG; im->quote = 0; buf_reset(&im->tok);
+            p = lt + 1;
+        } else if (im->quote){
+            const char *q = (const char*)memchr(p, im->quote, (size_t)(end - p));
+            const char *stop = q ? q + 1 : end;
+            buf_add(&im->tok, p, (size_t)(stop - p));
+            if (q) im->quote = 0;
+            p = stop;
+        } else {
+            const char *q = p;
+            while (q < end && *q != '>' && *q != '"' && *q != '\'') q++;
+            buf_add(&im->tok, p, (size_t)(q - p));
+            if (q == end) return;
+            if (*q == '>'){ html_tag(im); im->hstate = H_TEXT; }
+            else { im->quote = *q; buf_put(&im->tok, *q); }
+            p = q + 1;
+        }
+    }
+}
+
+// ---- JSON ----
+static int json_key(const char *k){
+    if (!strcmp(k, "name") || !strcmp(k, "title")) return K_NAME;
+    if (!strcmp(k, "url") || !strcmp(k, "uri") || !strcmp(k, "href")) return K_URL;
+    if (!strcmp(k, "folder")) return K_FOLDER;
+    if (!strcmp(k, "tags")) return K_TAGS;
+    if (!strcmp(k, "children")) return K_CHILDREN;
+    return K_NONE;
+}
+
+static JFrame *jtop(BMImport *im){ return im->nfr ? &im->fr[im->nfr - 1] : NULL; }
+
+static void json_value_done(BMImport *im){
+    JFrame *f = jtop(im);
+    if (f && f->kind == '{') f->key = K_NONE;
+}
+
+static int folder_new(BMImport *im, int parent, char *name){
+    if (im->nfold == im->cfold){ im->cfold = im->cfold ? im->cfold * 2 : 16; im->fold = (JFolder*)realloc(im->fold, (size_t)im->cfold * sizeof(JFolder)); }
+    JFolder *d = &im->fold[im->nfold];
+    d->name = name; d->parent = parent; d->path = NULL;
+    return im->nfold++;
+}
+
+static void json_open(BMImport *im, char kind){
+    JFrame *up = jtop(im);
+    if (up && up->kind == '{' && up->key == K_CHILDREN && kind == '[' && !up->is_folder){
+        up->is_folder = 1;
+        up->folder_at = folder_new(im, up->folder_at, NULL);   // named when the object closes
+    }
+    if (im->nfr == im->cfr){ im->cfr = im->cfr ? im->cfr * 2 : 16; im->fr = (JFrame*)realloc(im->fr, (size_t)im->cfr * sizeof(JFrame)); }
+    JFrame *f = &im->fr[im->nfr++];
+    memset(f, 0, sizeof *f);
+    f->kind = kind; f->want_key = kind == '{'; f->first = im->bm->size;
+    f->folder_at = up ? up->folder_at : -1;
+}
+
+// the item's own "folder" goes under the folders around it
+static void json_item_folder(BMImport *im, int idx, JFrame *f){
+    int node = f->folder_at;
+    if (f->folder && *f->folder){
+        if (node < 0){ bm_set_folder(im->bm, idx, f->folder); return; }
+        node = folder_new(im, node, f->folder); f->folder = NULL;
+    }
+    if (node < 0 && idx - im->base >= im->npend) return;
+    int slot = idx - im->base;
+    if (slot >= im->npend){
+        if (slot >= im->cpend){
+            while (slot >= im->cpend) im->cpend = im->cpend ? im->cpend * 2 : 256;
+            im->pend = (int*)realloc(im->pend, (size_t)im->cpend * sizeof(int));
+        }
+        while (im->npend <= slot) im->pend[im->npend++] = -1;
+    }
+    im->pend[slot] = node;
+}
+
+static void json_close(BMImport *im, char kind){
+    JFrame *f = jtop(im);
+    if (!f || f->kind != kind){ im->bad = 1; return; }
+    if (kind == '{'){
+        if (f->url && *f->url && strncmp(f->url, "place:", 6) != 0){
+            int idx = emit(im, f->name, f->url);
+            json_item_folder(im, idx, f);
+            add_tags(im, idx, f->tags.p);
+        } else if (f->is_folder && f->name && *f->name){
+            im->fold[f->folder_at].name = f->name; f->name = NULL;
+        }
+        free(f->name); free(f->url); free(f->folder); free(f->tags.p);
+    }
+    im->nfr--;
+    json_value_done(im);
+}
+
+static void json_string(BMImport *im){
+    JFrame *f = jtop(im);
+    const char *s = im->tok.n ? im->tok.p : "";
+    if (!f) return;
+    if (f->kind == '{' && f->want_key){ f->key = json_key(s); f->want_key = 0; return; }
+    if (f->kind == '{'){
+        switch (f->key){
+            case K_NAME:   free(f->name);   f->name = sdup(s); break;
+            case K_URL:    free(f->url);    f->url = sdup(s); break;
+            case K_FOLDER: free(f->folder); f->folder = sdup(s); break;
+            case K_TAGS:   buf_reset(&f->tags); buf_puts(&f->tags, s); break;   // "a,b" form
+            default: break;
+        }
+        f->key = K_NONE;
+        return;
+    }
+    JFrame *up = im->nfr > 1 ? &im->fr[im->nfr - 2] : NULL;
+    if (up && up->kind == '{' && up->key == K_TAGS){   // ["a","b"] form
+        if (up->tags.n) buf_put(&up->tags, ',');
+        buf_puts(&up->tags, s);
+    }
+}
+
+static void json_feed(BMImport *im, const char *p, size_t n){
+    for (size_t i = 0; i < n && !im->bad; ++i){
+        char c = p[i];
+        switch (im->jstate){
+        case J_STRING: {
+            size_t j = i;
+            while (j < n && p[j] != '"' && p[j] != '\\') j++;
+            buf_add(&im->tok, p + i, j - i);
+            i = j;
+            if (j == n) break;
+            if (p[j] == '\\') im->jstate = J_ESC;
+            else { im->jstate = J_VALUE; json_string(im); }
+            break;
+        }
+        case J_ESC:
+            im->jstate = J_STRING;
+            switch (c){
+                case 'n': buf_put(&im->tok, '\n'); break;
+                case 't': buf_put(&im->tok, '\t'); break;
+                case 'r': buf_put(&im->tok, '\r'); break;
+                case 'b': buf_put(&im->tok, '\b'); break;
+                case 'f': buf_put(&im->tok, '\f'); break;
+                case 'u': im->jstate = J_UESC; im->ucount = 0; im->uacc = 0; break;
+                default:  buf_put(&im->tok, c); break;
+            }
+            break;
+        case J_UESC:
+            if (!isxdigit((unsigned char)c)){ im->bad = 1; break; }
+            im->uacc = im->uacc * 16 + (unsigned)(isdigit((unsigned char)c) ? c - '0' : tolower((unsigned char)c) - 'a' + 10);
+            if (++im->ucount < 4) break;
+            im->jstate = J_STRING;
+            if (im->uacc >= 0xD800 && im->uacc < 0xDC00){ im->uhigh = im->uacc; break; }
+            if (im->uacc >= 0xDC00 && im->uacc < 0xE000 && im->uhigh){
+                utf8_put(&im->tok, 0x10000 + ((im->uhigh - 0xD800) << 10) + (im->uacc - 0xDC00));
+            } else utf8_put(&im->tok, im->uacc);
+            im->uhigh = 0;
+            break;
+        case J_SCALAR:
+            if (c != ',' && c != '}' && c != ']' && !isspace((unsigned char)c)) break;
+            im->jstate = J_VALUE;
+            json_value_done(im);
+            /* fall through */
+        default:
+            if (isspace((unsigned char)c) || c == ':') break;
+            if (c == '{' || c == '[') json_open(im, c);
+            else if (c == '}' || c == ']') json_close(im, c == '}' ? '{' : '[');
+            else if (c == ','){ JFrame *f = jtop(im); if (f && f->kind == '{') f->want_key = 1; }
+            else if (c == '"'){ im->jstate = J_STRING; buf_reset(&im->tok); }
+            else im->jstate = J_SCALAR;
+            break;
+        }
+    }
+}
+
+// ---- driver ----
+int bmi_feed(BMImport *im, const char *p, size_t n){
+    if (im->bad) return 0;
+    if (im->fmt == FMT_UNKNOWN){
+        size_t i = 0;
+        if (n >= 3 && memcmp(p, "\xEF\xBB\xBF", 3) == 0) i = 3;   // UTF-8 BOM
+        while (i < n && isspace((unsigned char)p[i])) i++;
+        if (i == n) return 1;
+        if (p[i] == '<') im->fmt = FMT_HTML;
+        else if (p[i] == '[' || p[i] == '{') im->fmt = FMT_JSON;
+        else { im->bad = 1; return 0; }
+        p += i; n -= i;
+    }
+    if (im->fmt == FMT_HTML) html_feed(im, p, n); else json_feed(im, p, n);
+    return !im->bad;
+}
+
+int bmi_close(BMImport *im){
+    if (im->fmt == FMT_JSON && (im->nfr || im->jstate != J_VALUE)) im->bad = 1;
+    // parents come first, so one pass joins every path
+    for (int i = 0; i < im->nfold; ++i){
+        JFolder *d = &im->fold[i];
+        const char *up = d->parent >= 0 ? im->fold[d->parent].path : NULL;
+        if (!d->name) d->path = up ? sdup(up) : NULL;
+        else if (!up) d->path = sdup(d->name);
+        else {
+            Buf b = {0};
+            buf_puts(&b, up); buf_put(&b, '/'); buf_puts(&b, d->name);
+            d->path = buf_finish(&b);
+        }
+    }
+    for (int i = 0; i < im->npend; ++i)
+        if (im->pend[i] >= 0 && im->fold[im->pend[i]].path) bm_set_folder(im->bm, im->base + i, im->fold[im->pend[i]].path);
+    for (int i = 0; i < im->nfold; ++i){ free(im->fold[i].name); free(im->fold[i].path); }
+    free(im->fold);
+    while (im->nfr){
+        JFrame *f = &im->fr[--im->nfr];
+        free(f->name); free(f->url); free(f->folder); free(f->tags.p);
+    }
+    for (int i = 0; i < im->fdepth; ++i) free(im->fstack[i]);
+    free(im->pend); free(im->fr); free(im->fstack);
+    free(im->tok.p); free(im->text.p); free(im->path.p); free(im->href); free(im->tags); free(im->pending_folder);
+    int n = im->bad ? -1 : im->added;
+    free(im);
+    return n;
+}
+
+int bm_import_stream(BMList *bm, FILE *f, BMAddFn add, void *ctx){
+    // exports run about 100 bytes a bookmark; reserve once up front
+    struct stat st;
+    int expect = fstat(fileno(f), &st) == 0 && S_ISREG(st.st_mode) ? (int)(st.st_size / 100) : 0;
+    bm_bulk_begin(bm, expect);
+    BMImport *im = bmi_open(bm, add, ctx);
+    char *chunk = (char*)malloc(IMPORT_CHUNK);
+    size_t got;
+    while ((got = fread(chunk, 1, IMPORT_CHUNK, f)) > 0)
+        if (!bmi_feed(im, chunk, got)) break;
+    free(chunk);
+    int n = bmi_close(im);
+    bm_bulk_end(bm);
+    return n;
+}
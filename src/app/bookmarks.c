@@ -2,9 +2,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include "bookmarks.h"
+#include "bmimport.h"
 
 // --- internal helpers ---
-static void bm_reserve(BMList *bm, int need){
+void bm_reserve(BMList *bm, int need){
     if (bm->cap >= need) return;
     int c = bm->cap ? bm->cap : 8;
     while (c < need) c <<= 1;
@@ -12,24 +13,69 @@ static void bm_reserve(BMList *bm, int need){
     bm->cap = c;
 }
 
-void bm_init(BMList *bm){ bm->data=NULL; bm->size=0; bm->cap=0; }
+void bm_init(BMList *bm){
+    bm->data=NULL; bm->size=0; bm->cap=0;
+    sm_init(&bm->tags); sm_init(&bm->folders); sm_init(&bm->by_name); bm->bulk=0;
+    bm->version=0; bm->frag=NULL; bm->frag_len=0; bm->frag_ver=0;
+}
+
+static void labels_free(StrMap *m){
+    for (int i=0;i<m->cap;++i){
+        if (!sm_live(&m->slots[i])) continue;
+        BMLabel *l = (BMLabel*)m->slots[i].val;
+        bmp_free(&l->ids); free(l->name); free(l);
+    }
+    sm_free(m);
+}
 
 void bm_destroy(BMList *bm){
-    for (int i=0;i<bm->size;++i){ free(bm->data[i].name); free(bm->data[i].url); }
-    free(bm->data); bm->data=NULL; bm->size=bm->cap=0;
+    for (int i=0;i<bm->size;++i){ free(bm->data[i].name); free(bm->data[i].url); free(bm->data[i].tags); }
+    free(bm->data);
+    labels_free(&bm->tags); labels_free(&bm->folders); sm_free(&bm->by_name);
+    free(bm->frag);
+    bm_init(bm);
 }
 
 int bm_add(BMList *bm, const char *name, const char *url){
     bm_reserve(bm, bm->size+1);
-    bm->data[bm->size].name = sdup(name?name:"");
-    bm->data[bm->size].url  = sdup(url?url:"");
+    BMItem *it = &bm->data[bm->size];
+    it->name = sdup(name?name:"");
+    it->url  = sdup(url?url:"");
+    it->folder = NULL; it->tags = NULL; it->ntags = 0;
+    if (!bm->bulk){
+        int created;
+        void **slot = sm_put(&bm->by_name, it->name, &created);
+        if (created) *slot = (void*)(intptr_t)(bm->size+1);
+    }
+    bm->version++;
     return bm->size++;
 }
 
 int bm_find_by_name(const BMList *bm, const char *name){
     if (!name) return -1;
-    for (int i=0;i<bm->size;++i) if (strcmp(bm->data[i].name, name)==0) return i;
-    return -1;
+    if (bm->bulk){   // index is stale until bm_bulk_end
+        for (int i=0;i<bm->size;++i) if (strcmp(bm->data[i].name, name)==0) return i;
+        return -1;
+    }
+    void **slot = sm_get(&bm->by_name, name);
+    return slot ? (int)(intptr_t)*slot - 1 : -1;
+}
+
+void bm_bulk_begin(BMList *bm, int expect){
+    if (expect > 0) bm_reserve(bm, bm->size + expect);
+    bm->bulk = 1;
+}
+
+void bm_bulk_end(BMList *bm){
+    if (!bm->bulk) return;
+    bm->bulk = 0;
+    sm_free(&bm->by_name);
+    sm_reserve(&bm->by_name, bm->size);
+    for (int i=0;i<bm->size;++i){
+        int created;
+        void **slot = sm_put(&bm->by_name, bm->data[i].name, &created);
+        if (created) *slot = (void*)(intptr_t)(i+1);
+    }
 }
 
 const BMItem* bm_get(const BMList *bm, int idx){
@@ -37,6 +83,117 @@ const BMItem* bm_get(const BMList *bm, int idx){
     return &bm->data[idx];
 }
 
+// ---- tags and folders ----
+// Labels are interned once and never removed, so items can hold their names.
+static BMLabel *label_get(StrMap *m, const char *name){
+    void **slot = sm_get(m, name);
+    if (slot) return (BMLabel*)*slot;
+    BMLabel *l = (BMLabel*)malloc(sizeof(BMLabel));
+    l->name = sdup(name); bmp_init(&l->ids);
+    *sm_put(m, l->name, NULL) = l;
+    return l;
+}
+
+int bm_tag(BMList *bm, int idx, const char *tag){
+    if (idx < 0 || idx >= bm->size || !tag || !*tag) return 0;
+    BMItem *it = &bm->data[idx];
+    BMLabel *l = label_get(&bm->tags, tag);
+    if (bmp_contains(&l->ids, (uint32_t)idx)) return 0;
+    bmp_add(&l->ids, (uint32_t)idx);
+    it->tags = (const char**)realloc((void*)it->tags, (size_t)(it->ntags+1)*sizeof(char*));
+    it->tags[it->ntags++] = l->name;
+    bm->version++;
+    return 1;
+}
+
+int bm_untag(BMList *bm, int idx, const char *tag){
+    if (idx < 0 || idx >= bm->size || !tag) return 0;
+    BMItem *it = &bm->data[idx];
+    void **slot = sm_get(&bm->tags, tag);
+    if (!slot) return 0;
+    BMLabel *l = (BMLabel*)*slot;
+    if (!bmp_contains(&l->ids, (uint32_t)idx)) return 0;
+    bmp_remove(&l->ids, (uint32_t)idx);
+    for (int i=0;i<it->ntags;++i)
+        if (it->tags[i] == l->name){ memmove((void*)&it->tags[i], &it->tags[i+1], (size_t)(it->ntags-i-1)*sizeof(char*)); it->ntags--; break; }
+    bm->version++;
+    return 1;
+}
+
+void bm_set_folder(BMList *bm, int idx, const char *folder){
+    if (idx < 0 || idx >= bm->size) return;
+    BMItem *it = &bm->data[idx];
+    if (folder && !*folder) folder = NULL;
+    if (it->folder && folder && strcmp(it->folder, folder)==0) return;
+    if (it->folder) bmp_remove(&((BMLabel*)*sm_get(&bm->folders, it->folder))->ids, (uint32_t)idx);
+    it->folder = NULL;
+    if (folder){
+        BMLabel *l = label_get(&bm->folders, folder);
+        bmp_add(&l->ids, (uint32_t)idx);
+        it->folder = l->name;
+    }
+    bm->version++;
+}
+
+const BMLabel* bm_tag_label(const BMList *bm, const char *tag){
+    void **slot = sm_get(&bm->tags, tag);
+    return slot ? (const BMLabel*)*slot : NULL;
+}
+
+const BMLabel* bm_folder_label(const BMList *bm, const char *folder){
+    void **slot = sm_get(&bm->folders, folder);
+    return slot ? (const BMLabel*)*slot : NULL;
+}
+
+static int by_card(const void *a, const void *b){
+    uint32_t x = bmp_count(*(const Bitmap* const*)a), y = bmp_count(*(const Bitmap* const*)b);
+    return x < y ? -1 : x > y;
+}
+
+// AND the required sets smallest first, then OR the alternatives and subtract
+// the exclusions; only with no positive term does it start from every id.
+void bm_query(const BMList *bm, const BMQuery *q, Bitmap *out){
+    bmp_free(out);
+    Bitmap acc, tmp; bmp_init(&acc); bmp_init(&tmp);
+    int nreq = q->nall + (q->folder ? 1 : 0);
+    const Bitmap **req = (const Bitmap**)malloc((size_t)(nreq ? nreq : 1) * sizeof(Bitmap*));
+    int k = 0;
+    for (int i=0;i<q->nall;++i){
+        const BMLabel *l = bm_tag_label(bm, q->all[i]);
+        if (!l){ free(req); return; }
+        req[k++] = &l->ids;
+    }
+    if (q->folder){
+        const BMLabel *l = bm_folder_label(bm, q->folder);
+        if (!l){ free(req); return; }
+        req[k++] = &l->ids;
+    }
+    qsort(req, (size_t)k, sizeof(Bitmap*), by_card);
+    if (k) bmp_copy(&acc, req[0]);
+    for (int i=1;i<k && acc.n;++i){ bmp_and(&tmp, &acc, req[i]); bmp_free(&acc); acc = tmp; bmp_init(&tmp); }
+    free(req);
+
+    if (q->nany){
+        Bitmap alt; bmp_init(&alt);
+        for (int i=0;i<q->nany;++i){
+            const BMLabel *l = bm_tag_label(bm, q->any[i]);
+            if (!l) continue;
+            bmp_or(&tmp, &alt, &l->ids); bmp_free(&alt); alt = tmp; bmp_init(&tmp);
+        }
+        if (k){ bmp_and(&tmp, &acc, &alt); bmp_free(&acc); bmp_free(&alt); acc = tmp; bmp_init(&tmp); }
+        else { bmp_free(&acc); acc = alt; }
+    } else if (!k) {
+        bmp_fill(&acc, (uint32_t)bm->size);
+    }
+
+    for (int i=0;i<q->nnone && acc.n;++i){
+        const BMLabel *l = bm_tag_label(bm, q->none[i]);
+        if (!l) continue;
+        bmp_andnot(&tmp, &acc, &l->ids); bmp_free(&acc); acc = tmp; bmp_init(&tmp);
+    }
+    *out = acc;
+}
+
 // ---- JSON I/O ----
 // We reuse a simple writer: write: [{"name":"..","url":".."},...]
 static void json_escape_str(FILE *f, const char *s){
@@ -62,47 +219,29 @@ void bm_save_json(FILE *f, const BMList *bm){
         fputc('{', f);
         fputs("\"name\":", f); json_escape_str(f, bm->data[i].name);
         fputs(",\"url\":", f);  json_escape_str(f, bm->data[i].url);
+        if (bm->data[i].folder){ fputs(",\"folder\":", f); json_escape_str(f, bm->data[i].folder); }
+        if (bm->data[i].ntags){
+            fputs(",\"tags\":[", f);
+            for (int t=0;t<bm->data[i].ntags;++t){ if (t) fputc(',', f); json_escape_str(f, bm->data[i].tags[t]); }
+            fputc(']', f);
+        }
         fputc('}', f);
     }
     fputc(']', f);
 }
 
-// Minimal parser for array of {"name":..,"url":..}. We’ll keep it simple:
-// feed it the bytes exactly as we wrote them (session loader passes correct slice).
-// Returns 1 on success.
+static int add_plain(void *ctx, const char *name, const char *url){
+    return bm_add((BMList*)ctx, name, url);
+}
+
+// Parses [...] (or any export bmimport understands) into bm, replacing its
+// contents. Returns 1 on success.
 int bm_load_json_array(const char *json, size_t n, BMList *bm){
-    // Very small permissive reader: scan for "name":"...","url":"..." pairs in order.
-    // For robustness you could reuse your JIn mini-parser; here we keep it tight.
-    bm_destroy(bm); bm_init(bm);
-    const char *p=json, *end=json+n;
-    while (p<end){
-        const char *name_key = strstr(p, "\"name\"");
-        if (!name_key) break;
-        const char *q = strchr(name_key, '"'); if (!q) break; // "
-        q = strchr(q+1, '"'); if (!q) break;                   // end "name"
-        const char *colon = strchr(q, ':'); if (!colon) break;
-        const char *v1 = strchr(colon, '"'); if (!v1) break;
-        const char *v1e = v1+1; while (v1e<end && !( *v1e=='"' && v1e[-1] != '\\')) v1e++;
-        if (v1e>=end) break;
-
-        const char *url_key = strstr(v1e, "\"url\"");
-        if (!url_key) break;
-        q = strchr(url_key, '"'); if (!q) break;
-        q = strchr(q+1, '"'); if (!q) break;
-        colon = strchr(q, ':'); if (!colon) break;
-        const char *v2 = strchr(colon, '"'); if (!v2) break;
-        const char *v2e = v2+1; while (v2e<end && !( *v2e=='"' && v2e[-1] != '\\')) v2e++;
-        if (v2e>=end) break;
-
-        // extract raw substrings (no unescape to keep it short)
-        size_t nlen = (size_t)(v1e - (v1+1));
-        size_t ulen = (size_t)(v2e - (v2+1));
-        char *name = (char*)malloc(nlen+1); memcpy(name, v1+1, nlen); name[nlen]='\0';
-        char *url  = (char*)malloc(ulen+1); memcpy(url,  v2+1, ulen); url [ulen]='\0';
-        bm_add(bm, name, url);
-        free(name); free(url);
-
-        p = v2e+1;
-    }
-    return 1;
+    bm_destroy(bm);
+    bm_bulk_begin(bm, 0);
+    BMImport *im = bmi_open(bm, add_plain, bm);
+    bmi_feed(im, json, n);
+    int ok = bmi_close(im) >= 0;
+    bm_bulk_end(bm);
+    return ok;
 }
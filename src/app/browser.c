@@ -1,51 +1,445 @@
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdatomic.h>
 #include "browser.h"
 #include "util.h"
+#include "trace.h"
+
+
+static atomic_ullong tab_serial;   // Browser.tab_id source, shared by every manager in the process
+
+
+// Ids only need to differ between tabs of the sessions being merged, which
+// may come from other processes: the clock, a per-process address and a
+// serial, mixed (splitmix64) so that no two differ in a few bits only.
+static uint64_t new_tab_id(void) {
+uint64_t z = (uint64_t)wall_ms() * 0x100000001b3ULL ^ (uint64_t)(uintptr_t)&tab_serial
+           ^ atomic_fetch_add(&tab_serial, 1) * 0x9e3779b97f4a7c15ULL;
+z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+z ^= z >> 31;
+return z ? z : 1;
+}
 
 
 void browser_init(Browser *b, const char *homepage, int back_cap) {
 b->current = sdup(homepage);
-ring_init(&b->back, back_cap);
-vec_init(&b->fwd);
+b->current_ts = wall_ms(); b->clock = b->current_ts;   // opening the tab is its first visit
+sp_init(&b->back, back_cap);
+sp_init(&b->fwd, SP_UNBOUNDED);
+b->cold = NULL;
+b->hook = NULL; b->hook_ctx = NULL;
+b->id = -1; b->uid = 0; b->tab_id = new_tab_id();
+b->version = 0; b->frag = NULL; b->frag_len = 0; b->frag_ver = 0;
+b->hash = 0; b->hash_ver = b->version - 1;
+b->branches = NULL; b->nbranches = 0;
+b->mem = 0; b->mem_queued = 0;
+}
+
+
+static atomic_uint branch_serial;   // Branch.id source, shared by every manager in the process
+
+
+Branch *branch_new(const char *at, int64_t at_ts, StrPack *pages) {
+Branch *br = (Branch*)malloc(sizeof(Branch));
+br->refs = 1;
+br->id = atomic_fetch_add(&branch_serial, 1) + 1;
+br->frag = NULL; br->frag_len = 0;
+br->at = sdup(at); br->at_ts = at_ts;
+br->pages = *pages; sp_init(pages, pages->cap);
+br->ts = at_ts;
+for (int i = 0; i < br->pages.size; ++i) if (sp_ts(&br->pages, i) > br->ts) br->ts = sp_ts(&br->pages, i);
+return br;
+}
+
+
+void branch_release(Branch *br) {
+if (!br || --br->refs > 0) return;
+free(br->at);
+free(br->frag);
+sp_free(&br->pages);
+free(br);
+}
+
+
+static size_t branch_mem(const Branch *br) {
+return (sizeof(Branch) + strlen(br->at) + 1 + sp_bytes(&br->pages) + (br->frag ? br->frag_len + 1 : 0)) / (size_t)br->refs;
+}
+
+
+static void drop_branch(Browser *b, int i) {
+branch_release(b->branches[i]);
+memmove(b->branches + i, b->branches + i + 1, (size_t)(b->nbranches - i - 1) * sizeof(Branch*));
+b->nbranches--;
+}
+
+
+// keeps the forward stack a visit is about to discard; the pack moves over whole
+static void archive_fwd(Browser *b) {
+if (b->nbranches == BROWSER_BRANCHES) drop_branch(b, 0);
+if (!b->branches) b->branches = (Branch**)malloc(BROWSER_BRANCHES * sizeof(Branch*));
+b->branches[b->nbranches++] = branch_new(b->current, b->current_ts, &b->fwd);
+}
+
+
+static void emit(Browser *b, int ev, const char *url, int64_t ts) {
+if (b->hook) b->hook(b->hook_ctx, b, ev, url, ts);
+}
+
+
+// wall-clock ms, never behind this tab's previous stamp; visits within one ms
+// share it and keep their order by insertion in the time index
+static int64_t stamp(Browser *b) {
+int64_t t = wall_ms();
+if (t < b->clock) t = b->clock;
+return b->clock = t;
 }
 
 
 void browser_destroy(Browser *b) {
 free(b->current);
-ring_free(&b->back);
-vec_clear_free(&b->fwd);
-vec_free(&b->fwd);
+sp_free(&b->back);
+sp_free(&b->fwd);
+cold_close(b->cold);
+b->cold = NULL;
+free(b->frag);
+b->frag = NULL;
+for (int i = 0; i < b->nbranches; ++i) branch_release(b->branches[i]);
+free(b->branches);
+b->branches = NULL; b->nbranches = 0;
+}
+
+
+void browser_attach_cold(Browser *b, ColdSeg *c) {
+cold_close(b->cold);
+b->cold = c;
+}
+
+
+// Push onto back; the entry a full ring would drop goes to the cold tier
+// instead. When the tier cannot take it the ring grows by one and keeps it:
+// an entry is never lost to a failed write (ColdSeg.failed counts them).
+static void back_push(Browser *b, const char *url, int64_t ts) {
+if (b->back.cap == 0) {
+if (!b->cold) { emit(b, HIST_DROP, url, ts); return; }
+if (cold_append(b->cold, url, strlen(url), ts)) return;
+b->back.cap = 1;
+} else if (sp_full(&b->back) && b->back.size > 0) {
+if (!b->cold) emit(b, HIST_DROP, sp_at(&b->back, 0), sp_ts(&b->back, 0));
+else if (!cold_append(b->cold, sp_at(&b->back, 0), sp_len(&b->back, 0), sp_ts(&b->back, 0))) b->back.cap++;
+}
+sp_push_ts(&b->back, url, ts);
+}
+
+
+// A walk of `steps` past the hot ring pages in, in one read, every cold
+// entry it will pass over plus a ring's worth to land on. The ring is
+// unbounded until browser_back restores its cap; by then it holds no more
+// than the cap.
+static void back_refill(Browser *b, int steps) {
+if (!b->cold || b->cold->count == 0) return;
+long k = b->back.cap > 0 ? (long)steps + b->back.cap : b->cold->count;
+if (k > b->cold->count) k = b->cold->count;
+StrPack w; sp_init(&w, SP_UNBOUNDED);
+if (!cold_pop_tail(b->cold, (int)k, &w)) { sp_free(&w); return; }
+for (int i = 0; i < b->back.size; ++i) sp_push_ts(&w, sp_at(&b->back, i), sp_ts(&b->back, i));
+sp_free(&b->back);
+b->back = w;
+}
+
+
+// entries the cold tier cannot take stay in the ring, which grows to hold them
+void browser_fit_back(Browser *b, int back_cap) {
+int keep = b->back.size;
+if (back_cap >= 0 && keep > back_cap) keep = back_cap;
+int out = 0;
+for (; out < b->back.size - keep; ++out) {
+if (!b->cold) emit(b, HIST_DROP, sp_at(&b->back, out), sp_ts(&b->back, out));
+else if (!cold_append(b->cold, sp_at(&b->back, out), sp_len(&b->back, out), sp_ts(&b->back, out))) break;
+}
+StrPack np; sp_init(&np, back_cap >= 0 && b->back.size - out > back_cap ? b->back.size - out : back_cap);
+for (int i = out; i < b->back.size; ++i) sp_push_ts(&np, sp_at(&b->back, i), sp_ts(&b->back, i));
+sp_free(&b->back);
+b->back = np;
+b->version++;
+}
+
+
+int browser_back_total(const Browser *b) {
+return b->back.size + (b->cold ? b->cold->count : 0);
+}
+
+
+static void emit_all(Browser *b, int ev) {
+if (!b->hook) return;
+if (b->cold) {
+StrPack page; sp_init(&page, SP_UNBOUNDED);
+for (int from = 0; from < b->cold->count; from += COLD_PAGE) {
+int n = b->cold->count - from; if (n > COLD_PAGE) n = COLD_PAGE;
+sp_clear(&page);
+if (!cold_read_range(b->cold, from, n, &page)) break;
+for (int i = 0; i < page.size; ++i) emit(b, ev, sp_at(&page, i), sp_ts(&page, i));
+}
+sp_free(&page);
+}
+for (int i = 0; i < b->back.size; ++i) emit(b, ev, sp_at(&b->back, i), sp_ts(&b->back, i));
+for (int i = 0; i < b->fwd.size; ++i) emit(b, ev, sp_at(&b->fwd, i), sp_ts(&b->fwd, i));
+emit(b, ev, b->current, b->current_ts);
+}
+
+
+// the cold tier only ever holds entries older than the hot back ring
+int64_t browser_last_ts(const Browser *b) {
+int64_t m = b->current_ts;
+for (int i = 0; i < b->back.size; ++i) if (sp_ts(&b->back, i) > m) m = sp_ts(&b->back, i);
+for (int i = 0; i < b->fwd.size; ++i) if (sp_ts(&b->fwd, i) > m) m = sp_ts(&b->fwd, i);
+return m;
+}
+
+
+void browser_sync_clock(Browser *b) {
+int64_t m = browser_last_ts(b);
+if (m > b->clock) b->clock = m;
+}
+
+
+static uint64_t hash_entry(uint64_t h, const char *url, size_t len) {
+return fnv1a64(url, len + 1, h);   // the NUL separates entries
+}
+
+
+// Oldest to newest: cold, back, current, forward, then the back/forward
+// sizes so moving through the same urls still changes the hash.
+uint64_t browser_hash(Browser *b) {
+if (b->hash_ver != b->version) {
+uint64_t h = FNV1A64_SEED;
+if (b->cold) {
+StrPack page; sp_init(&page, SP_UNBOUNDED);
+for (int from = 0; from < b->cold->count; from += COLD_PAGE) {
+int n = b->cold->count - from; if (n > COLD_PAGE) n = COLD_PAGE;
+sp_clear(&page);
+if (!cold_read_range(b->cold, from, n, &page)) break;
+for (int i = 0; i < page.size; ++i) h = hash_entry(h, sp_at(&page, i), sp_len(&page, i));
+}
+sp_free(&page);
+}
+for (int i = 0; i < b->back.size; ++i) h = hash_entry(h, sp_at(&b->back, i), sp_len(&b->back, i));
+h = hash_entry(h, b->current, strlen(b->current));
+for (int i = b->fwd.size - 1; i >= 0; --i) h = hash_entry(h, sp_at(&b->fwd, i), sp_len(&b->fwd, i));
+int sizes[2] = { browser_back_total(b), b->fwd.size };
+b->hash = fnv1a64(sizes, sizeof sizes, h);
+b->hash_ver = b->version;
+}
+return b->hash;
+}
+
+
+void browser_announce(Browser *b) {
+emit_all(b, HIST_ADD);
+emit(b, HIST_ENTER, b->current, b->current_ts);
+}
+
+
+void browser_forget(Browser *b) {
+emit(b, HIST_LEAVE, b->current, b->current_ts);
+emit_all(b, HIST_DROP);
+}
+
+
+// a shared branch is charged in equal parts to the tabs holding it
+size_t browser_mem(const Browser *b) {
+size_t n = sizeof(Browser) + strlen(b->current) + 1 + sp_bytes(&b->back) + sp_bytes(&b->fwd);
+if (b->frag) n += b->frag_len + 1;
+for (int i = 0; i < b->nbranches; ++i) n += branch_mem(b->branches[i]) + sizeof(Branch*);
+return n;
+}
+
+
+// Back before forward: back entries are older, and the far end of the
+// forward stack goes first so `forward` still walks the pages in order.
+// The oldest branch goes whole, when it was last seen before either.
+int64_t browser_evict_ts(const Browser *b) {
+int64_t t = INT64_MAX;
+if (b->back.size) t = sp_ts(&b->back, 0);
+else if (b->fwd.size) t = sp_ts(&b->fwd, 0);
+if (b->nbranches && b->branches[0]->ts < t) t = b->branches[0]->ts;
+return t;
+}
+
+
+// with a cold tier the oldest back entry only moves to disk; when that
+// write fails nothing is evicted and 0 tells the caller to look elsewhere
+int browser_evict(Browser *b) {
+int r;
+int64_t t = b->back.size ? sp_ts(&b->back, 0) : b->fwd.size ? sp_ts(&b->fwd, 0) : INT64_MAX;
+if (b->nbranches && b->branches[0]->ts < t) {
+r = b->branches[0]->pages.size;
+drop_branch(b, 0);
+} else if (b->back.size) {
+if (b->cold) {
+if (!cold_append(b->cold, sp_at(&b->back, 0), sp_len(&b->back, 0), sp_ts(&b->back, 0))) return 0;
+r = -1;
+}
+else { emit(b, HIST_DROP, sp_at(&b->back, 0), sp_ts(&b->back, 0)); r = 1; }
+sp_drop_front(&b->back);
+} else if (b->fwd.size) {
+emit(b, HIST_DROP, sp_at(&b->fwd, 0), sp_ts(&b->fwd, 0));
+sp_drop_front(&b->fwd);
+r = 1;
+} else return 0;
+// the cached fragment is stale now; let the memory go with the entry
+free(b->frag); b->frag = NULL; b->frag_len = 0;
+b->version++;
+return r;
 }
 
 
 const char *browser_visit(Browser *b, const char *url) {
-ring_push_back(&b->back, b->current);
-vec_clear_free(&b->fwd);
+TRACE_BEGIN(span, "browser_visit");
+emit(b, HIST_VISIT, url, 0);
+emit(b, HIST_LEAVE, b->current, b->current_ts);
+back_push(b, b->current, b->current_ts);
+// the forward stack leaves the history but is kept as a branch off this page
+for (int i = 0; i < b->fwd.size; ++i) emit(b, HIST_DROP, sp_at(&b->fwd, i), sp_ts(&b->fwd, i));
+if (b->fwd.size) archive_fwd(b);
+free(b->current);
 b->current = sdup(url);
+b->current_ts = stamp(b);
+b->version++;
+emit(b, HIST_ADD, b->current, b->current_ts);
+emit(b, HIST_ENTER, b->current, b->current_ts);
+TRACE_END(span);
 return b->current;
 }
 
 
 const char *browser_back(Browser *b, int steps) {
+TRACE_BEGIN(span, "browser_back");
+int cap = b->back.cap;
+if (steps > b->back.size) back_refill(b, steps - b->back.size);
 while (steps-- > 0) {
-char *prev = ring_pop_back(&b->back);
+int64_t ts;
+char *prev = sp_pop_ts(&b->back, &ts);
 if (!prev) break;
-vec_push(&b->fwd, b->current);
-b->current = prev;
+emit(b, HIST_LEAVE, b->current, b->current_ts);
+sp_push_ts(&b->fwd, b->current, b->current_ts);
+free(b->current);
+b->current = prev; b->current_ts = ts;
+b->version++;
+emit(b, HIST_ENTER, b->current, b->current_ts);
 }
+if (cap >= 0 && b->back.size > cap) browser_fit_back(b, cap);   // only a ring of 0 paged in more than it keeps
+else b->back.cap = cap;
+TRACE_END(span);
 return b->current;
 }
 
 
 const char *browser_forward(Browser *b, int steps) {
+TRACE_BEGIN(span, "browser_forward");
 while (steps-- > 0) {
-char *next = vec_pop(&b->fwd);
+int64_t ts;
+char *next = sp_pop_ts(&b->fwd, &ts);
 if (!next) break;
-ring_push_back(&b->back, b->current);
-b->current = next;
+emit(b, HIST_LEAVE, b->current, b->current_ts);
+back_push(b, b->current, b->current_ts);
+free(b->current);
+b->current = next; b->current_ts = ts;
+b->version++;
+emit(b, HIST_ENTER, b->current, b->current_ts);
 }
+TRACE_END(span);
 return b->current;
 }
 
 
-const char *browser_current(const Browser *b) { return b->current; }
\ No newline at end of file
+const char *browser_current(const Browser *b) { return b->current; }
+
+
+// The cold tier is a file of b's own, so its entries come along in memory
+// and the new owner spills them again; the branches are shared.
+Browser *browser_clone(Browser *b) {
+Browser *nb = (Browser*)malloc(sizeof(Browser));
+browser_init(nb, b->current, SP_UNBOUNDED);
+nb->current_ts = b->current_ts; nb->clock = b->clock;
+if (b->cold && b->cold->count) {
+for (int from = 0; from < b->cold->count; from += COLD_PAGE) {
+int n = b->cold->count - from; if (n > COLD_PAGE) n = COLD_PAGE;
+if (!cold_read_range(b->cold, from, n, &nb->back)) break;
+}
+for (int i = 0; i < b->back.size; ++i) sp_push_ts(&nb->back, sp_at(&b->back, i), sp_ts(&b->back, i));
+} else {
+sp_copy(&nb->back, &b->back);
+nb->back.cap = SP_UNBOUNDED;
+}
+sp_copy(&nb->fwd, &b->fwd);
+if (b->nbranches) {
+nb->branches = (Branch**)malloc(BROWSER_BRANCHES * sizeof(Branch*));
+for (int i = 0; i < b->nbranches; ++i) { nb->branches[i] = b->branches[i]; nb->branches[i]->refs++; }
+nb->nbranches = b->nbranches;
+}
+return nb;
+}
+
+
+static int entry_is(const char *url, int64_t ts, const char *at, int64_t at_ts) {
+return (at_ts < 0 || ts == at_ts) && strcmp(url, at) == 0;
+}
+
+
+// Steps from current to the nearest entry (at, at_ts): > 0 back, < 0
+// forward, 0 when current is it, INT_MIN when the history no longer holds
+// it. at_ts < 0 matches any stamp. The cold tier is read newest page first.
+static int find_entry(const Browser *b, const char *at, int64_t at_ts) {
+if (entry_is(b->current, b->current_ts, at, at_ts)) return 0;
+int best = INT_MIN;
+for (int j = b->fwd.size - 1; j >= 0; --j)
+if (entry_is(sp_at(&b->fwd, j), sp_ts(&b->fwd, j), at, at_ts)) { best = -(b->fwd.size - j); break; }
+for (int j = b->back.size - 1; j >= 0; --j)
+if (entry_is(sp_at(&b->back, j), sp_ts(&b->back, j), at, at_ts)) {
+int d = b->back.size - j;
+return best == INT_MIN || d < -best ? d : best;
+}
+if (best != INT_MIN || !b->cold) return best;
+StrPack page; sp_init(&page, SP_UNBOUNDED);
+int d = INT_MIN;
+for (int hi = b->cold->count; hi > 0 && d == INT_MIN; hi -= COLD_PAGE) {
+int from = hi > COLD_PAGE ? hi - COLD_PAGE : 0;
+sp_clear(&page);
+if (!cold_read_range(b->cold, from, hi - from, &page)) break;
+for (int j = page.size - 1; j >= 0; --j)
+if (entry_is(sp_at(&page, j), sp_ts(&page, j), at, at_ts)) { d = b->back.size + (b->cold->count - (from + j)); break; }
+}
+sp_free(&page);
+return d;
+}
+
+
+// The tab goes to the branch point by moving along the history it already
+// has, as back/forward would: restoring is not a visit, so nothing new is
+// stamped or reported as one. The entry with the point's own stamp is
+// preferred; a tab loaded without stamps settles for the nearest same url.
+int browser_restore_branch(Browser *b, int i) {
+if (i < 0 || i >= b->nbranches) return 0;
+Branch *br = b->branches[i];
+int d = find_entry(b, br->at, br->at_ts);
+if (d == INT_MIN) d = find_entry(b, br->at, -1);
+if (d == INT_MIN) return -1;
+memmove(b->branches + i, b->branches + i + 1, (size_t)(b->nbranches - i - 1) * sizeof(Branch*));
+b->nbranches--;
+if (d > 0) browser_back(b, d);
+else if (d < 0) browser_forward(b, -d);
+// whatever forward stack the tab has there is archived in turn
+if (b->fwd.size) {
+for (int j = 0; j < b->fwd.size; ++j) emit(b, HIST_DROP, sp_at(&b->fwd, j), sp_ts(&b->fwd, j));
+archive_fwd(b);
+}
+// an unshared branch hands its pages over, a shared one is copied
+if (br->refs == 1) { sp_free(&b->fwd); b->fwd = br->pages; sp_init(&br->pages, SP_UNBOUNDED); }
+else sp_copy(&b->fwd, &br->pages);
+branch_release(br);
+for (int j = 0; j < b->fwd.size; ++j) emit(b, HIST_ADD, sp_at(&b->fwd, j), sp_ts(&b->fwd, j));
+b->version++;
+return 1;
+}
@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "cold.h"
+
+ColdSeg *cold_open(const char *path) {
+    ColdSeg *c = (ColdSeg*)calloc(1, sizeof(ColdSeg));
+    if (!c) return NULL;
+    strncpy(c->path, path, sizeof c->path - 1);
+    char ipath[272]; snprintf(ipath, sizeof ipath, "%s.idx", c->path);
+    c->data = fopen(c->path, "w+b");
+    c->idx  = fopen(ipath, "w+b");
+    if (!c->data || !c->idx) { cold_close(c); return NULL; }
+    return c;
+}
+
+void cold_close(ColdSeg *c) {
+    if (!c) return;
+    char ipath[272]; snprintf(ipath, sizeof ipath, "%s.idx", c->path);
+    if (c->data) { fclose(c->data); remove(c->path); }
+    if (c->idx)  { fclose(c->idx); remove(ipath); }
+    free(c);
+}
+
+// offset of record i; i == count means the append position
+static long cold_offset(ColdSeg *c, int i) {
+    if (i >= c->count) return c->end;
+    uint64_t off = 0;
+    if (fseek(c->idx, (long)i * (long)sizeof off, SEEK_SET) != 0) return -1;
+    if (fread(&off, sizeof off, 1, c->idx) != 1) return -1;
+    return (long)off;
+}
+
+// The record is flushed before it counts, so a full disk fails this append
+// rather than a later one. A failed append leaves count and end alone, and
+// whatever part of the record did reach the file is overwritten by the next.
+int cold_append(ColdSeg *c, const char *s, size_t n, int64_t ts) {
+    uint32_t len = (uint32_t)n;
+    uint64_t off = (uint64_t)c->end;
+    if (fseek(c->data, c->end, SEEK_SET) != 0
+        || fwrite(&len, sizeof len, 1, c->data) != 1 || fwrite(&ts, sizeof ts, 1, c->data) != 1
+        || fwrite(s, 1, n, c->data) != n || fflush(c->data) != 0
+        || fseek(c->idx, (long)c->count * (long)sizeof off, SEEK_SET) != 0
+        || fwrite(&off, sizeof off, 1, c->idx) != 1 || fflush(c->idx) != 0) { clearerr(c->data); clearerr(c->idx); c->failed++; return 0; }
+    c->end += (long)(sizeof len + sizeof ts + n);
+    c->count++;
+    return 1;
+}
+
+int cold_read_range(ColdSeg *c, int from, int n, StrPack *dst) {
+    if (from < 0 || n <= 0 || from + n > c->count) return 0;
+    long lo = cold_offset(c, from), hi = cold_offset(c, from + n);
+    if (lo < 0 || hi < lo) return 0;
+    size_t span = (size_t)(hi - lo);
+    char *buf = (char*)malloc(span + 1);
+    if (!buf) return 0;
+    if (fseek(c->data, lo, SEEK_SET) != 0 || fread(buf, 1, span, c->data) != span) { free(buf); return 0; }
+    size_t p = 0;
+    for (int i = 0; i < n; ++i) {
+        uint32_t len; memcpy(&len, buf + p, sizeof len); p += sizeof len;
+        int64_t ts; memcpy(&ts, buf + p, sizeof ts); p += sizeof ts;
+        char save = buf[p + len]; buf[p + len] = '\0';   // terminate in place
+        sp_push_ts(dst, buf + p, ts);
+        buf[p + len] = save; p += len;
+    }
+    free(buf);
+    return 1;
+}
+
+int cold_pop_tail(ColdSeg *c, int n, StrPack *dst) {
+    if (n > c->count) n = c->count;
+    if (n <= 0) return 0;
+    int from = c->count - n;
+    long lo = cold_offset(c, from);
+    if (lo < 0 || !cold_read_range(c, from, n, dst)) return 0;
+    // the tail is free again; the next spill overwrites it in place
+    c->count = from;
+    c->end = lo;
+    return n;
+}
@@ -0,0 +1,614 @@
+// src/app/commands.c — command parser/dispatcher shared by the CLI and tools
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "commands.h"
+#include "browser.h"
+#include "session.h"
+#include "strpack.h"    // for sp_at in print
+#include "features.h"   // undo + autosave
+#include "bookmarks.h"  // bookmarks commands
+#include "bmimport.h"
+#include "util.h"     // wall_ms for history
+#include "sessdiff.h"
+#include "trace.h"
+
+/* ------------------ helpers ------------------ */
+static void putln(FILE *out, const char *s) { fputs(s, out); fputc('\n', out); }
+
+static void print_tab(FILE *out, const Browser *b) {
+    fprintf(out, "CURRENT: %s\n", b->current);
+    fprintf(out, "BACK   : [");
+    if (b->cold && b->cold->count) fprintf(out, "(+%d on disk)%s", b->cold->count, b->back.size ? ", " : "");
+    for (int j=0; j<b->back.size; ++j) {
+        if (j) fprintf(out, ", ");
+        fprintf(out, "%s", sp_at(&b->back, j));
+    }
+    fprintf(out, "]\nFORWARD: [");
+    for (int j=0; j<b->fwd.size; ++j) {
+        if (j) fprintf(out, ", ");
+        fprintf(out, "%s", sp_at(&b->fwd, j));
+    }
+    fprintf(out, "]\n");
+}
+
+typedef char HitPos[32];
+
+typedef struct { int tab, hit; } HitOrd;   // tab id (-1: bookmark), index into the hits
+
+static int by_hit_tab(const void *a, const void *b) {
+    const HitOrd *x = (const HitOrd*)a, *y = (const HitOrd*)b;
+    return x->tab != y->tab ? (x->tab > y->tab) - (x->tab < y->tab) : x->hit - y->hit;
+}
+
+// claim the hit named url, if it is still waiting for a position
+static int hit_claim(StrMap *m, const char *url, HitPos *pos, const char *fmt, int d) {
+    void **v = sm_get(m, url);
+    if (!v) return 0;
+    snprintf(pos[(intptr_t)*v - 1], sizeof(HitPos), fmt, d);
+    sm_del(m, url);
+    return 1;
+}
+
+// Where in its tab's history each hit sits, nearest to current first. Hits
+// are grouped by tab and each tab's history is walked once, however many of
+// its urls matched, stopping as soon as every one has been placed.
+static void describe_hits(const UrlHit *h, int n, HitPos *pos) {
+    HitOrd *ord = (HitOrd*)malloc((size_t)(n ? n : 1) * sizeof(HitOrd));
+    for (int i = 0; i < n; ++i) { ord[i].tab = h[i].tab ? h[i].tab->id : -1; ord[i].hit = i; }
+    qsort(ord, (size_t)n, sizeof(HitOrd), by_hit_tab);
+    StrMap m; sm_init(&m);
+    for (int s = 0, e; s < n; s = e) {
+        const Browser *b = h[ord[s].hit].tab;
+        for (e = s; e < n && ord[e].tab == ord[s].tab; ++e) {}
+        if (!b) continue;   // bookmarks
+        for (int k = s; k < e; ++k) {
+            *sm_put(&m, h[ord[k].hit].url, NULL) = (void*)(intptr_t)(ord[k].hit + 1);
+            snprintf(pos[ord[k].hit], sizeof(HitPos), "back >%d", b->back.size);   // only in the cold tier
+        }
+        int left = e - s;
+        left -= hit_claim(&m, b->current, pos, "current", 0);
+        for (int j=b->back.size-1; j>=0 && left; --j) left -= hit_claim(&m, sp_at(&b->back, j), pos, "back %d", b->back.size - j);
+        for (int j=b->fwd.size-1; j>=0 && left; --j) left -= hit_claim(&m, sp_at(&b->fwd, j), pos, "forward %d", b->fwd.size - j);
+        sm_free(&m); sm_init(&m);
+    }
+    sm_free(&m);
+    free(ord);
+}
+
+static int by_id(const void *a, const void *b) {
+    return (*(Browser* const*)a)->id - (*(Browser* const*)b)->id;
+}
+
+// snapshot of the tabs on a host, ordered by id (NULL when none)
+static Browser **domain_tabs(TabManager *tm, const char *host, int *n) {
+    const DomainEnt *e = domidx_get(&tm->domains, host);
+    *n = e ? e->ntabs : 0;
+    if (!*n) return NULL;
+    Browser **v = (Browser**)malloc((size_t)*n * sizeof(Browser*));
+    memcpy(v, e->tabs, (size_t)*n * sizeof(Browser*));
+    qsort(v, (size_t)*n, sizeof(Browser*), by_id);
+    return v;
+}
+
+// next whitespace-separated token of *p, NUL-terminated in place (NULL at end)
+static char *next_tok(char **p) {
+    char *s = *p;
+    while (isspace((unsigned char)*s)) s++;
+    if (!*s) { *p = s; return NULL; }
+    char *e = s; while (*e && !isspace((unsigned char)*e)) e++;
+    if (*e) *e++ = '\0';
+    *p = e;
+    return s;
+}
+
+static int bm_resolve(const TabManager *tm, const char *s) {
+    if (!s) return -1;
+    if (isdigit((unsigned char)s[0])) return bm_get(&tm->bookmarks, atoi(s)) ? atoi(s) : -1;
+    return bm_find_by_name(&tm->bookmarks, s);
+}
+
+static int import_add(void *ctx, const char *name, const char *url) {
+    return tm_bookmark_add((TabManager*)ctx, name, url);
+}
+
+static void print_bm(FILE *out, int i, const BMItem *it) {
+    fprintf(out, "[%d] %s -> %s", i, it->name, it->url);
+    if (it->folder) fprintf(out, "  /%s", it->folder);
+    for (int t=0; t<it->ntags; ++t) fprintf(out, " #%s", it->tags[t]);
+    fputc('\n', out);
+}
+
+// history bounds: "now", a duration ago (90s, 15m, 1h, 2d, 1w), epoch seconds
+// or ms, or local YYYY-MM-DD[THH:MM[:SS]]
+static int parse_when(const char *s, int64_t now, int64_t *out) {
+    if (strcmp(s, "now") == 0) { *out = now; return 1; }
+    char *end;
+    long long v = strtoll(s, &end, 10);
+    if (end != s && v >= 0) {
+        if (!*end) { *out = (end - s >= 12) ? (int64_t)v : (int64_t)v * 1000; return 1; }
+        if (!end[1]) {
+            int64_t unit = 0;
+            switch (*end) {
+            case 's': unit = 1000; break;
+            case 'm': unit = 60 * 1000; break;
+            case 'h': unit = 3600 * 1000; break;
+            case 'd': unit = 86400 * 1000; break;
+            case 'w': unit = 7 * 86400 * 1000; break;
+            }
+            if (unit) { *out = now - (int64_t)v * unit; return 1; }
+        }
+    }
+    struct tm t; memset(&t, 0, sizeof t);
+    int n = sscanf(s, "%d-%d-%dT%d:%d:%d", &t.tm_year, &t.tm_mon, &t.tm_mday, &t.tm_hour, &t.tm_min, &t.tm_sec);
+    if (n < 3 || n == 4) return 0;
+    t.tm_year -= 1900; t.tm_mon -= 1; t.tm_isdst = -1;
+    time_t tt = mktime(&t);
+    if (tt == (time_t)-1) return 0;
+    *out = (int64_t)tt * 1000;
+    return 1;
+}
+
+static void fmt_when(int64_t ms, char *out, size_t n) {
+    time_t tt = (time_t)(ms / 1000);
+    struct tm t;
+#if defined(_WIN32) || defined(_WIN64)
+    localtime_s(&t, &tt);
+#else
+    localtime_r(&tt, &t);
+#endif
+    strftime(out, n, "%Y-%m-%d %H:%M:%S", &t);
+}
+
+static const char *fmt_bytes(size_t n, char *out, size_t cap) {
+    if (n < 1024) snprintf(out, cap, "%zu B", n);
+    else if (n < ((size_t)1 << 20)) snprintf(out, cap, "%.1f KB", n / 1024.0);
+    else if (n < ((size_t)1 << 30)) snprintf(out, cap, "%.1f MB", n / (1024.0 * 1024.0));
+    else snprintf(out, cap, "%.2f GB", n / (1024.0 * 1024.0 * 1024.0));
+    return out;
+}
+
+static char* lstrip(char *s){ while(isspace((unsigned char)*s)) s++; return s; }
+static void  rstrip(char *s){ size_t n=strlen(s); while(n&&isspace((unsigned char)s[n-1])) s[--n]='\0'; }
+
+void print_help(FILE *out) {
+    putln(out,
+"commands:\n"
+"  visit <url>\n"
+"  back [n]\n"
+"  forward [n]\n"
+"  current\n"
+"  print\n"
+"  tabs [--domain <host>]\n"
+"  domains [n]\n"
+"  newtab [homepage]\n"
+"  duplicate [id]              new tab with the same history\n"
+"  switch <id>\n"
+"  close [id | --domain <host>]\n"
+"  reopen\n"
+"  branches [restore <n>]      forward stacks cut off by a new visit in this tab\n"
+"  predict [k]                 likeliest next pages from here, across all tabs\n"
+"  autosave [on|off|<path.json[.lz]>]\n"
+"  search <substring>\n"
+"  history [--since <t>] [--until <t>] [--last <dur>] [--limit n]\n"
+"          (t: now, 15m/2h/3d ago, epoch s|ms, YYYY-MM-DD[THH:MM[:SS]])\n"
+"  bm add <name> <url> [--folder <f>] [--tag <t>]...\n"
+"  bm tag|untag <id|name> <tag>...\n"
+"  bm folder <id|name> [folder]\n"
+"  bm list [--tag <t>]... [--any <t>]... [--not <t>]... [--folder <f>] [--count]\n"
+"  bm tags\n"
+"  bm import <bookmarks.html|bookmarks.json|->\n"
+"  bm open <id|name>\n"
+"  save <path.json|path.json.lz>\n"
+"  load <path.json|path.json.lz|->   (- reads stdin)\n"
+"  diff <path>                 tabs changed / only here / only in the file\n"
+"  merge [--prune] <path>      add the file's new tabs, newer side wins on changed ones\n"
+"  trace [on|off|clear|dump <file.json>]   (builds with make TRACE=1)\n"
+"  stats                       memory use, budget and evictions\n"
+"  quit"
+    );
+}
+
+static int dispatch(TabManager *tm, UndoStack *undo, const char *cmdline, FILE *out) {
+    char buf[2048];
+    strncpy(buf, cmdline, sizeof buf - 1);
+    buf[sizeof buf - 1] = '\0';
+
+    char *line = lstrip(buf);
+    // allow lines copied with a leading prompt '>'
+    if (*line == '>') { line++; while (*line==' '||*line=='\t') line++; }
+    if (*line == '#') return 1;   // comment
+    rstrip(line);
+    if (*line == '\0') return 1;  // empty
+
+    // first token (lowercased)
+    char *sp = strpbrk(line, " \t");
+    size_t clen = sp ? (size_t)(sp - line) : strlen(line);
+    char cbuf[64]; if (clen >= sizeof cbuf) clen = sizeof cbuf - 1;
+    memcpy(cbuf, line, clen); cbuf[clen] = '\0';
+    for (char *p=cbuf; *p; ++p) *p = (char)tolower((unsigned char)*p);
+
+    char *arg = sp ? lstrip(sp) : NULL;
+    Browser *b = tm_active(tm);
+
+    if (strcmp(cbuf, "help") == 0) {
+        print_help(out);
+
+    } else if (strcmp(cbuf, "visit") == 0) {
+        if (!b) { putln(out, "no active tab"); return 1; }
+        if (!arg || !*arg) { putln(out, "usage: visit <url>"); return 1; }
+        browser_visit(b, arg);
+        putln(out, b->current);
+        autosave_maybe(tm);
+
+    } else if (strcmp(cbuf, "back") == 0) {
+        if (!b) { putln(out, "no active tab"); return 1; }
+        int n = 1; if (arg && *arg) n = atoi(arg);
+        fprintf(out, "%s\n", browser_back(b, n));
+        autosave_maybe(tm);
+
+    } else if (strcmp(cbuf, "forward") == 0) {
+        if (!b) { putln(out, "no active tab"); return 1; }
+        int n = 1; if (arg && *arg) n = atoi(arg);
+        fprintf(out, "%s\n", browser_forward(b, n));
+        autosave_maybe(tm);
+
+    } else if (strcmp(cbuf, "current") == 0) {
+        if (!b) { putln(out, "no active tab"); return 1; }
+        putln(out, browser_current(b));
+
+    } else if (strcmp(cbuf, "print") == 0) {
+        if (!b) { putln(out, "no active tab"); return 1; }
+        print_tab(out, b);
+
+    } else if (strcmp(cbuf, "tabs") == 0 && arg && strncmp(arg, "--domain", 8) == 0) {
+        const char *host = lstrip(arg + 8);
+        if (!*host) { putln(out, "usage: tabs --domain <host>"); return 1; }
+        int n; Browser **v = domain_tabs(tm, host, &n);
+        if (!n) putln(out, "(no tabs)");
+        for (int i=0;i<n;++i) fprintf(out, "[%d]%s %s\n", v[i]->id, (v[i]->id==tm->active)?"*":" ", v[i]->current);
+        free(v);
+
+    } else if (strcmp(cbuf, "domains") == 0) {
+        int limit = (arg && *arg) ? atoi(arg) : 20;
+        const DomainEnt **top = NULL;
+        int n = domidx_top(&tm->domains, &top);
+        if (n == 0) putln(out, "(no domains)");
+        for (int i=0;i<n && i<limit;++i) fprintf(out, "%6ld entries %4d tabs  %s\n", top[i]->history, top[i]->ntabs, top[i]->host);
+        free(top);
+
+    } else if (strcmp(cbuf, "history") == 0) {
+        int64_t now = wall_ms(), since = 0, until = INT64_MAX;
+        int limit = 0, ok = 1;
+        char *p = arg ? arg : (char*)"", *tok;
+        while (ok && (tok = next_tok(&p))) {
+            char *val = next_tok(&p);
+            if (!val) ok = 0;
+            else if (strcmp(tok, "--since") == 0) ok = parse_when(val, now, &since);
+            else if (strcmp(tok, "--until") == 0) ok = parse_when(val, now, &until);
+            else if (strcmp(tok, "--last") == 0) { ok = parse_when(val, now, &since) && since <= now; until = INT64_MAX; }
+            else if (strcmp(tok, "--limit") == 0) ok = (limit = atoi(val)) > 0;
+            else ok = 0;
+        }
+        if (!ok) { putln(out, "usage: history [--since <t>] [--until <t>] [--last <dur>] [--limit n]"); return 1; }
+        TVisit *v = NULL;
+        int n = timeidx_query(&tm->times, since, until, &v);
+        if (n == 0) putln(out, "(no history)");
+        // with a limit, show the most recent ones, still oldest first
+        for (int i = (limit && n > limit) ? n - limit : 0; i < n; ++i) {
+            char when[32]; fmt_when(v[i].ts, when, sizeof when);
+            fprintf(out, "%s  [%d] %s\n", when, v[i].tab->id, v[i].url);
+        }
+        free(v);
+
+    } else if (strcmp(cbuf, "tabs") == 0) {
+        if (tm->count == 0) { putln(out, "(no tabs)"); return 1; }
+        for (int i=0;i<tm->count;++i) {
+            fprintf(out, "[%d]%s %s\n", i, (i==tm->active)?"*":" ", tm->tabs[i]->current);
+        }
+
+    } else if (strcmp(cbuf, "newtab") == 0) {
+        const char *home = (arg && *arg) ? arg : "about:blank";
+        int id = tm_new_tab(tm, home);
+        tm_switch(tm, id);
+        fprintf(out, "opened tab %d -> %s\n", id, tm->tabs[id]->current);
+        autosave_maybe(tm);
+
+    } else if (strcmp(cbuf, "duplicate") == 0) {
+        int id = (arg && *arg) ? atoi(arg) : tm->active;
+        if (!(0 <= id && id < tm->count)) { putln(out, "invalid tab id"); return 1; }
+        int nid = tm_adopt_tab(tm, browser_clone(tm->tabs[id]));
+        tm_switch(tm, nid);
+        fprintf(out, "duplicated tab %d as %d -> %s\n", id, nid, tm->tabs[nid]->current);
+        autosave_maybe(tm);
+
+    } else if (strcmp(cbuf, "branches") == 0) {
+        if (!b) { putln(out, "no active tab"); return 1; }
+        char *p = arg ? arg : (char*)"", *sub = next_tok(&p), *nstr = next_tok(&p);
+        if (sub && strcmp(sub, "restore") == 0 && nstr) {
+            int r = browser_restore_branch(b, atoi(nstr));
+            if (r <= 0) { putln(out, r ? "branch point is no longer in this tab's history" : "no such branch"); return 1; }
+            fprintf(out, "%s (forward: %d pages)\n", b->current, b->fwd.size);
+            autosave_maybe(tm);
+            return 1;
+        }
+        if (sub) { putln(out, "usage: branches [restore <n>]"); return 1; }
+        if (!b->nbranches) putln(out, "(no branches)");
+        // newest first, pages in the order `forward` would walk them
+        for (int i=b->nbranches-1; i>=0; --i) {
+            const Branch *br = b->branches[i];
+            char when[32]; fmt_when(br->ts, when, sizeof when);
+            fprintf(out, "[%d] %s  %s", i, when, br->at);
+            for (int j=br->pages.size-1; j>=0 && j>=br->pages.size-3; --j) fprintf(out, " -> %s", sp_at(&br->pages, j));
+            if (br->pages.size > 3) fprintf(out, " (+%d more)", br->pages.size - 3);
+            fputc('\n', out);
+        }
+
+    } else if (strcmp(cbuf, "predict") == 0) {
+        if (!b) { putln(out, "no active tab"); return 1; }
+        int k = (arg && *arg) ? atoi(arg) : 3;
+        if (k < 1 || k > PRED_K) { fprintf(out, "usage: predict [k]   (1..%d)\n", PRED_K); return 1; }
+        const PredRow *r = pred_get(&tm->pred, b->current);
+        if (!r || !r->nnext) { fprintf(out, "(no prediction for %s)\n", b->current); return 1; }
+        // n can overcount by err once a successor has been evicted; show the bound when it matters
+        for (int i=0; i<r->nnext && i<k; ++i) {
+            const PredNext *x = &r->next[i];
+            fprintf(out, "%d. %s  %.0f%% (%u/%u", i + 1, x->to->url, 100.0 * x->n / r->total, (unsigned)x->n, (unsigned)r->total);
+            if (x->err) fprintf(out, ", +-%u", (unsigned)x->err);
+            fputs(")\n", out);
+        }
+
+    } else if (strcmp(cbuf, "switch") == 0) {
+        if (!arg || !*arg) { putln(out, "usage: switch <id>"); return 1; }
+        int id = atoi(arg);
+        if (0 <= id && id < tm->count) {
+            tm_switch(tm, id);
+            fprintf(out, "active tab %d -> %s\n", id, tm->tabs[id]->current);
+            autosave_maybe(tm);
+        } else {
+            putln(out, "invalid tab id");
+        }
+
+    } else if (strcmp(cbuf, "close") == 0 && arg && strncmp(arg, "--domain", 8) == 0) {
+        const char *host = lstrip(arg + 8);
+        if (!*host) { putln(out, "usage: close --domain <host>"); return 1; }
+        int n; Browser **v = domain_tabs(tm, host, &n);
+        // highest id first so the remaining ids stay valid
+        for (int i=n-1;i>=0;--i) { undo_push_tab(undo, v[i]); tm_close_tab(tm, v[i]->id); }
+        free(v);
+        fprintf(out, "closed %d tab%s\n", n, n==1?"":"s");
+        if (n) autosave_maybe(tm);
+
+    } else if (strcmp(cbuf, "close") == 0) {
+        int id = (arg && *arg) ? atoi(arg) : tm->active;
+        if (tm->count == 0) { putln(out, "no tabs"); return 1; }
+        if (!(0 <= id && id < tm->count)) { putln(out, "invalid tab id"); return 1; }
+        // push closed tab to undo stack, then close
+        undo_push_tab(undo, tm->tabs[id]);
+        tm_close_tab(tm, id);
+        if (tm->count) fprintf(out, "now at tab %d -> %s\n", tm->active, tm->tabs[tm->active]->current);
+        else putln(out, "(all tabs closed)");
+        autosave_maybe(tm);
+
+    } else if (strcmp(cbuf, "reopen") == 0) {
+        int id = undo_reopen_top(undo, tm);
+        if (id >= 0) { fprintf(out, "reopened tab %d -> %s\n", id, tm->tabs[id]->current); autosave_maybe(tm); }
+        else putln(out, "nothing to reopen");
+
+    } else if (strcmp(cbuf, "autosave") == 0) {
+        if (!arg || !*arg) {
+            fprintf(out, "autosave is %s (%s)\n", tm->autosave?"on":"off",
+                   tm->autosave_path[0]?tm->autosave_path:"session.json");
+        } else if (strncmp(arg,"on",2)==0) {
+            autosave_on(tm, NULL); putln(out, "autosave on");
+        } else if (strncmp(arg,"off",3)==0) {
+            autosave_off(tm); putln(out, "autosave off");
+        } else { // treat as path
+            autosave_on(tm, arg); fprintf(out, "autosave on (%s)\n", tm->autosave_path);
+        }
+
+    } else if (strcmp(cbuf, "bm") == 0) {
+        const char *usage = "usage: bm add|tag|untag|folder|list|tags|import|open ... (see help)";
+        if (!arg||!*arg) { putln(out, usage); }
+        else {
+            char sub[16]; char rest[1024]; sub[0]=0; rest[0]=0;
+            sscanf(arg, "%15s %1023[^\n]", sub, rest);
+            for (char *p=sub;*p;++p)*p=(char)tolower((unsigned char)*p);
+            char *cur = rest;
+            BMList *bm = &tm->bookmarks;
+
+            if (strcmp(sub,"add")==0) {
+                char *name = next_tok(&cur), *url = next_tok(&cur);
+                if (!name || !url || strncmp(name,"--",2)==0 || strncmp(url,"--",2)==0) { putln(out, "usage: bm add <name> <url> [--folder <f>] [--tag <t>]..."); return 1; }
+                int idx = tm_bookmark_add(tm, name, url);
+                for (char *t; (t = next_tok(&cur)); ) {
+                    char *v = next_tok(&cur);
+                    if (!v) { fprintf(out, "missing value for %s\n", t); break; }
+                    if (strcmp(t,"--folder")==0) bm_set_folder(bm, idx, v);
+                    else if (strcmp(t,"--tag")==0) bm_tag(bm, idx, v);
+                    else { fprintf(out, "unknown option %s\n", t); break; }
+                }
+                fprintf(out, "bookmark "); print_bm(out, idx, bm_get(bm, idx)); autosave_maybe(tm);
+            } else if (strcmp(sub,"tag")==0 || strcmp(sub,"untag")==0) {
+                int id = bm_resolve(tm, next_tok(&cur));
+                if (id < 0) { putln(out, "bookmark not found"); return 1; }
+                int changed = 0;
+                for (char *t; (t = next_tok(&cur)); )
+                    changed += sub[0]=='t' ? bm_tag(bm, id, t) : bm_untag(bm, id, t);
+                print_bm(out, id, bm_get(bm, id));
+                if (changed) autosave_maybe(tm);
+            } else if (strcmp(sub,"folder")==0) {
+                int id = bm_resolve(tm, next_tok(&cur));
+                if (id < 0) { putln(out, "bookmark not found"); return 1; }
+                bm_set_folder(bm, id, next_tok(&cur));
+                print_bm(out, id, bm_get(bm, id)); autosave_maybe(tm);
+            } else if (strcmp(sub,"list")==0) {
+                if (bm->size==0) { putln(out, "(no bookmarks)"); return 1; }
+                enum { MAXQ = 32 };
+                const char *all[MAXQ], *any[MAXQ], *none[MAXQ];
+                BMQuery q = { all, 0, any, 0, none, 0, NULL };
+                int count_only = 0, filtered = 0;
+                for (char *t; (t = next_tok(&cur)); ) {
+                    if (strcmp(t,"--count")==0) { count_only = 1; continue; }
+                    char *v = next_tok(&cur);
+                    if (!v) { fprintf(out, "missing value for %s\n", t); return 1; }
+                    if      (strcmp(t,"--tag")==0 && q.nall < MAXQ)   all[q.nall++] = v;
+                    else if (strcmp(t,"--any")==0 && q.nany < MAXQ)   any[q.nany++] = v;
+                    else if (strcmp(t,"--not")==0 && q.nnone < MAXQ) none[q.nnone++] = v;
+                    else if (strcmp(t,"--folder")==0) q.folder = v;
+                    else { fprintf(out, "bad option %s\n", t); return 1; }
+                    filtered = 1;
+                }
+                if (!filtered) {
+                    if (count_only) fprintf(out, "%d bookmarks\n", bm->size);
+                    else for (int i=0;i<bm->size;++i) print_bm(out, i, &bm->data[i]);
+                    return 1;
+                }
+                Bitmap hits; bmp_init(&hits);
+                bm_query(bm, &q, &hits);
+                uint32_t *ids, n = bmp_to_array(&hits, &ids);
+                if (count_only) fprintf(out, "%u bookmarks\n", (unsigned)n);
+                else if (n == 0) putln(out, "(no matches)");
+                else for (uint32_t i=0;i<n;++i) print_bm(out, (int)ids[i], &bm->data[ids[i]]);
+                free(ids); bmp_free(&hits);
+            } else if (strcmp(sub,"tags")==0) {
+                const StrMap *maps[2] = { &bm->folders, &bm->tags };
+                int any = 0;
+                for (int m=0; m<2; ++m)
+                    for (int i=0;i<maps[m]->cap;++i) {
+                        if (!sm_live(&maps[m]->slots[i])) continue;
+                        const BMLabel *l = (const BMLabel*)maps[m]->slots[i].val;
+                        uint32_t c = bmp_count(&l->ids);
+                        if (c) { fprintf(out, "%s%s (%u)\n", m ? "#" : "/", l->name, (unsigned)c); any = 1; }
+                    }
+                if (!any) putln(out, "(no tags or folders)");
+            } else if (strcmp(sub,"import")==0) {
+                if (!*rest) { putln(out, "usage: bm import <bookmarks.html|bookmarks.json|->"); return 1; }
+                FILE *f = strcmp(rest,"-")==0 ? stdin : fopen(rest, "rb");
+                if (!f) { fprintf(out, "cannot open %s\n", rest); return 1; }
+                int before = bm->size;
+                int n = bm_import_stream(bm, f, import_add, tm);
+                if (f != stdin) fclose(f);
+                if (n < 0) fprintf(out, "import stopped at malformed input after %d bookmarks\n", bm->size - before);
+                else fprintf(out, "imported %d bookmarks\n", n);
+                if (bm->size != before) autosave_maybe(tm);   // once, not per item
+            } else if (strcmp(sub,"open")==0) {
+                if (!b){ putln(out, "no active tab"); }
+                else if (!*rest){ putln(out, "usage: bm open <id|name>"); }
+                else {
+                    const BMItem* it = bm_get(bm, bm_resolve(tm, rest));
+                    if (!it) putln(out, "bookmark not found");
+                    else { browser_visit(b, it->url); putln(out, b->current); autosave_maybe(tm); }
+                }
+            } else {
+                putln(out, usage);
+            }
+        }
+
+    } else if (strcmp(cbuf, "search") == 0) {
+        if (!arg || !*arg) { putln(out, "usage: search <substring>"); return 1; }
+        UrlHit *hits = NULL;
+        int n = urlidx_search(&tm->search, arg, &hits);
+        if (n == 0) putln(out, "(no matches)");
+        HitPos *pos = (HitPos*)malloc((size_t)(n ? n : 1) * sizeof(HitPos));
+        describe_hits(hits, n, pos);
+        for (int i=0;i<n;++i) {
+            if (!hits[i].tab) { fprintf(out, "[bm] %s\n", hits[i].url); continue; }
+            fprintf(out, "[%d] %-10s %s\n", hits[i].tab->id, pos[i], hits[i].url);
+        }
+        free(pos);
+        free(hits);
+
+    } else if (strcmp(cbuf, "save") == 0) {
+        if (!arg || !*arg) { putln(out, "usage: save <file.json>"); return 1; }
+        if (save_session_json(arg, tm)) putln(out, "saved.");
+        else putln(out, "save failed.");
+
+    } else if (strcmp(cbuf, "load") == 0) {
+        if (!arg || !*arg) { putln(out, "usage: load <file.json>"); return 1; }
+        if (load_session_json(arg, tm, tm->back_cap_default)) { putln(out, "loaded."); autosave_maybe(tm); }
+        else putln(out, "load failed.");
+
+    } else if (strcmp(cbuf, "diff") == 0 || strcmp(cbuf, "merge") == 0) {
+        int merge = cbuf[0] == 'm', prune = 0;
+        char *p = arg ? arg : (char*)"", *path = NULL, *tok;
+        while ((tok = next_tok(&p))) {
+            if (merge && strcmp(tok, "--prune") == 0) prune = 1;
+            else path = tok;
+        }
+        if (!path) { putln(out, merge ? "usage: merge [--prune] <file.json>" : "usage: diff <file.json>"); return 1; }
+        TabManager other;
+        if (!session_load_scratch(path, &other)) { tm_destroy(&other); putln(out, "load failed."); return 1; }
+        SessionDiff d; session_diff(tm, &other, &d);
+        if (!merge) {
+            for (int i=0;i<d.nchanged;++i)
+                fprintf(out, "~ [%d] %s -> %s\n", d.changed[i].a, tm->tabs[d.changed[i].a]->current, other.tabs[d.changed[i].b]->current);
+            for (int i=0;i<d.nonly_a;++i) fprintf(out, "- [%d] %s\n", d.only_a[i], tm->tabs[d.only_a[i]]->current);
+            for (int i=0;i<d.nonly_b;++i) fprintf(out, "+ %s\n", other.tabs[d.only_b[i]]->current);
+            fprintf(out, "%d same, %d changed, %d only here, %d only in %s\n", d.nsame, d.nchanged, d.nonly_a, d.nonly_b, path);
+        } else {
+            MergeStats st;
+            session_merge(tm, &other, &d, prune, undo, &st);
+            fprintf(out, "merged: %d added, %d updated, %d kept as is, %d %s\n", st.added, st.updated, st.kept,
+                   prune ? st.pruned : d.nonly_a, prune ? "closed" : "only here");
+            if (st.added || st.updated || st.pruned) autosave_maybe(tm);
+        }
+        session_diff_free(&d);
+        tm_destroy(&other);
+
+    } else if (strcmp(cbuf, "trace") == 0) {
+        char *p = arg ? arg : (char*)"";
+        char *sub = next_tok(&p), *path = next_tok(&p);
+        if (!trace_available()) putln(out, "tracing is not compiled in (rebuild with make TRACE=1)");
+        else if (!sub) fprintf(out, "tracing is %s\n", trace_is_on() ? "on" : "off");
+        else if (strcmp(sub, "on") == 0) { trace_set(1); putln(out, "tracing on"); }
+        else if (strcmp(sub, "off") == 0) { trace_set(0); putln(out, "tracing off"); }
+        else if (strcmp(sub, "clear") == 0) { trace_clear(); putln(out, "trace cleared"); }
+        else if (strcmp(sub, "dump") == 0 && path) {
+            int n = trace_dump(path);
+            if (n < 0) putln(out, "trace dump failed.");
+            else fprintf(out, "wrote %d events to %s\n", n, path);
+        }
+        else putln(out, "usage: trace [on|off|clear|dump <file.json>]");
+
+    } else if (strcmp(cbuf, "stats") == 0) {
+        long hot = 0, cold = 0, failed = 0;
+        for (int i=0;i<tm->count;++i) {
+            const Browser *t = tm->tabs[i];
+            hot += t->back.size + t->fwd.size + 1;
+            if (t->cold) { cold += t->cold->count; failed += t->cold->failed; }
+        }
+        const MemBudget *m = &tm->mem;
+        char used[24], tabs[24], und[24], bms[24], prd[24], lim[24];
+        fprintf(out, "tabs %d, %ld history entries in memory, %ld on disk, %d closed tabs on undo\n",
+                tm->count, hot, cold, undo->blobs.size);
+        fprintf(out, "memory %s (tabs %s, undo %s, bookmarks %s, next-visit model %s), limit %s\n",
+                fmt_bytes(mem_used(tm), used, sizeof used), fmt_bytes(m->tabs, tabs, sizeof tabs),
+                fmt_bytes(m->undo, und, sizeof und), fmt_bytes(m->bookmarks, bms, sizeof bms),
+                fmt_bytes(m->pred, prd, sizeof prd), m->limit ? fmt_bytes(m->limit, lim, sizeof lim) : "none");
+        fprintf(out, "evicted %ld entries, spilled %ld to disk, dropped %ld closed tabs in %ld passes\n",
+                m->evicted, m->spilled, m->undo_dropped, m->passes);
+        if (m->pred_dropped) fprintf(out, "forgot %ld urls of the next-visit model\n", m->pred_dropped);
+        if (failed) fprintf(out, "%ld entries could not be written to disk and stayed in memory\n", failed);
+
+    } else if (strcmp(cbuf, "quit") == 0 || strcmp(cbuf, "exit") == 0) {
+        return 0; // stop loop
+    } else {
+        putln(out, "unknown command. try 'help'.");
+    }
+    return 1;
+}
+
+/* returns 1 to continue loop, 0 to exit */
+int process_command(TabManager *tm, UndoStack *undo, const char *cmdline, FILE *out) {
+    TRACE_BEGIN(span, "command");
+    int r = dispatch(tm, undo, cmdline, out);
+    mem_settle(tm, undo);
+    if (tm->view) view_publish(tm, undo);
+    TRACE_END_ARG(span, cmdline);
+    return r;
+}
@@ -0,0 +1,107 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "domain.h"
+#include "browser.h"
+#include "util.h"
+
+int url_host(const char *url, char *out, size_t n){
+    out[0] = '\0';
+    if (!url || n == 0) return 0;
+    const char *p = strstr(url, "://");
+    if (p) p += 3;
+    else {
+        // "about:blank", "mailto:x" have no host; bare "gfg.org/x" does
+        const char *colon = strchr(url, ':'), *slash = strchr(url, '/');
+        if (colon && (!slash || colon < slash) && !isdigit((unsigned char)colon[1])) return 0;
+        p = url;
+    }
+    const char *end = p + strcspn(p, "/?#");
+    const char *at = memchr(p, '@', (size_t)(end - p));
+    if (at) p = at + 1;
+    const char *port = memchr(p, ':', (size_t)(end - p));
+    if (port) end = port;
+    if (end - p > 4 && strncmp(p, "www.", 4) == 0) p += 4;
+    size_t k = 0;
+    for (; p < end && k + 1 < n; ++p) out[k++] = (char)tolower((unsigned char)*p);
+    out[k] = '\0';
+    return k > 0;
+}
+
+void domidx_init(DomainIndex *dx){ sm_init(&dx->by_host); um_init(&dx->slot); }
+
+void domidx_free(DomainIndex *dx){
+    for (int i=0;i<dx->by_host.cap;++i){
+        if (!sm_live(&dx->by_host.slots[i])) continue;
+        DomainEnt *e = (DomainEnt*)dx->by_host.slots[i].val;
+        free(e->tabs); free(e->host); free(e);
+    }
+    sm_free(&dx->by_host); um_free(&dx->slot);
+}
+
+static DomainEnt *dom_lookup(DomainIndex *dx, const char *host, int create){
+    void **v = sm_get(&dx->by_host, host);
+    if (v) return (DomainEnt*)*v;
+    if (!create) return NULL;
+    DomainEnt *e = (DomainEnt*)calloc(1, sizeof(DomainEnt));
+    e->host = sdup(host);
+    *sm_put(&dx->by_host, e->host, NULL) = e;
+    return e;
+}
+
+static void dom_release(DomainIndex *dx, DomainEnt *e){
+    if (e->history > 0 || e->ntabs > 0) return;
+    sm_del(&dx->by_host, e->host);
+    free(e->tabs); free(e->host); free(e);
+}
+
+void domidx_event(DomainIndex *dx, struct Browser *b, int ev, const char *url){
+    char host[256];
+    if (!url_host(url, host, sizeof host)) return;
+    DomainEnt *e = dom_lookup(dx, host, ev == HIST_ADD || ev == HIST_ENTER);
+    if (!e) return;
+    switch (ev){
+    case HIST_ADD:  e->history++; break;
+    case HIST_DROP: e->history--; dom_release(dx, e); break;
+    case HIST_ENTER:
+        if (e->ntabs == e->ctabs){ e->ctabs = e->ctabs ? e->ctabs*2 : 4; e->tabs = (struct Browser**)realloc(e->tabs, (size_t)e->ctabs*sizeof(*e->tabs)); }
+        e->tabs[e->ntabs] = b;
+        *um_put(&dx->slot, b->uid, NULL) = (void*)(intptr_t)(++e->ntabs);
+        break;
+    case HIST_LEAVE: {
+        void **sp = um_get(&dx->slot, b->uid);
+        if (!sp) break;
+        int i = (int)(intptr_t)*sp - 1;
+        um_del(&dx->slot, b->uid);
+        if (i != e->ntabs - 1){   // swap-remove
+            e->tabs[i] = e->tabs[e->ntabs - 1];
+            *um_get(&dx->slot, e->tabs[i]->uid) = (void*)(intptr_t)(i + 1);
+        }
+        e->ntabs--;
+        dom_release(dx, e);
+        break;
+    }
+    }
+}
+
+const DomainEnt *domidx_get(const DomainIndex *dx, const char *host){
+    char norm[256];
+    if (!url_host(host, norm, sizeof norm)) return NULL;
+    void **v = sm_get(&dx->by_host, norm);
+    return v ? (const DomainEnt*)*v : NULL;
+}
+
+static int by_history_desc(const void *a, const void *b){
+    const DomainEnt *x = *(const DomainEnt* const*)a, *y = *(const DomainEnt* const*)b;
+    if (x->history != y->history) return x->history < y->history ? 1 : -1;
+    return strcmp(x->host, y->host);
+}
+
+int domidx_top(const DomainIndex *dx, const DomainEnt ***out){
+    int n = 0;
+    *out = (const DomainEnt**)malloc((size_t)(dx->by_host.count ? dx->by_host.count : 1) * sizeof(DomainEnt*));
+    for (int i=0;i<dx->by_host.cap;++i)
+        if (sm_live(&dx->by_host.slots[i])) (*out)[n++] = (const DomainEnt*)dx->by_host.slots[i].val;
+    qsort((void*)*out, (size_t)n, sizeof(DomainEnt*), by_history_desc);
+    return n;
+}
@@ -4,32 +4,35 @@
 #include "features.h"
 #include "session.h"   // single-tab helpers
 #include "util.h"
+#include "trace.h"
 
 // ---- Undo stack ----
-void undo_init(UndoStack *u){ vec_init(&u->blobs); }
-void undo_destroy(UndoStack *u){ vec_clear_free(&u->blobs); vec_free(&u->blobs); }
+void undo_init(UndoStack *u){ vec_init(&u->blobs); u->bytes = 0; }
+void undo_destroy(UndoStack *u){ vec_clear_free(&u->blobs); vec_free(&u->blobs); u->bytes = 0; }
 
-void undo_push_tab(UndoStack *u, const Browser *b) {
-    char *obj = session_serialize_tab_json(b);  // JSON object: {"current":...,"back":[...],"forward":[...]}
-    if (obj) vec_push(&u->blobs, obj);
+void undo_push_tab(UndoStack *u, Browser *b) {
+    TRACE_BEGIN(span, "undo_push_tab");
+    // JSON object: {"current":...,"back":[...],"forward":[...]}, usually already cached by autosave;
+    // the cached one names branches by id, so a tab with branches carries them inline instead
+    char *obj = b->nbranches ? session_serialize_tab_json(b) : sdup(session_tab_fragment(b, NULL));
+    if (obj) { vec_push(&u->blobs, obj); u->bytes += strlen(obj) + 1; }
+    TRACE_END(span);
 }
 
 int undo_reopen_top(UndoStack *u, TabManager *tm) {
+    TRACE_BEGIN(span, "undo_reopen_top");
     char *obj = vec_pop(&u->blobs);
-    if (!obj) return -1;
+    if (obj) u->bytes -= strlen(obj) + 1;
     Browser *nb = NULL;
-    if (!session_deserialize_tab_json(obj, &nb, tm->back_cap_default)) { free(obj); return -1; }
-    free(obj);
-
-    // Append new tab
-    // reserve
-    if (tm->cap <= tm->count) {
-        int c = tm->cap ? tm->cap : 4; while (c <= tm->count) c <<= 1;
-        tm->tabs = (Browser**)realloc(tm->tabs, (size_t)c * sizeof(Browser*)); tm->cap = c;
+    int id = -1;
+    // deserialize uncapped so deep history survives; tm_adopt_tab re-caps it
+    if (obj && session_deserialize_tab_json(obj, &nb, SP_UNBOUNDED)) {
+        // Append new tab (re-attaches the cold tier when spilling is on)
+        id = tm_adopt_tab(tm, nb);
+        tm->active = id;
     }
-    tm->tabs[tm->count] = nb;
-    int id = tm->count++;
-    tm->active = id;
+    free(obj);
+    TRACE_END(span);
     return id;
 }
 
@@ -45,8 +48,144 @@ void autosave_on(TabManager *tm, const char *path_or_null) {
 }
 void autosave_off(TabManager *tm) { tm->autosave = 0; }
 
+// The model changes on every visit and can outweigh the tabs many times
+// over, so rewriting it after each command would dominate autosave; it is
+// written once, when the session ends.
 void autosave_maybe(const TabManager *tm) {
+    if (!tm->autosave) return;
+    const char *p = tm->autosave_path[0] ? tm->autosave_path : "session.json";
+    save_session_json_nomodel(p, tm);
+}
+
+void autosave_final(const TabManager *tm) {
     if (!tm->autosave) return;
     const char *p = tm->autosave_path[0] ? tm->autosave_path : "session.json";
     save_session_json(p, tm);
 }
+
+// ---- Memory budget ----
+typedef struct { int64_t ts; Browser *b; PredRow *r; } Victim;   // a tab keyed by its next eviction, or a model row by its last update
+
+static void victim_down(Victim *h, int n, int i) {
+    for (;;) {
+        int l = 2 * i + 1, m = i;
+        if (l < n && h[l].ts < h[m].ts) m = l;
+        if (l + 1 < n && h[l + 1].ts < h[m].ts) m = l + 1;
+        if (m == i) return;
+        Victim t = h[i]; h[i] = h[m]; h[m] = t;
+        i = m;
+    }
+}
+
+static void recharge(TabManager *tm, Browser *b) {
+    tm->mem.tabs -= b->mem;
+    b->mem = browser_mem(b);
+    tm->mem.tabs += b->mem;
+}
+
+static size_t bookmarks_mem(const BMList *bm) {
+    size_t n = (size_t)bm->cap * sizeof(BMItem) + (bm->frag ? bm->frag_len + 1 : 0);
+    for (int i = 0; i < bm->size; ++i)
+        n += strlen(bm->data[i].name) + strlen(bm->data[i].url) + 2 + (size_t)bm->data[i].ntags * sizeof(char*);
+    return n;
+}
+
+size_t mem_used(const TabManager *tm) {
+    return tm->mem.tabs + tm->mem.undo + tm->mem.bookmarks + tm->mem.pred;
+}
+
+static void settle_queue(TabManager *tm) {
+    MemBudget *m = &tm->mem;
+    for (int i = 0; i < m->ndirty; ++i) { recharge(tm, m->dirty[i]); m->dirty[i]->mem_queued = 0; }
+    m->ndirty = 0;
+}
+
+void mem_settle(TabManager *tm, UndoStack *undo) {
+    MemBudget *m = &tm->mem;
+    settle_queue(tm);
+    m->undo = undo ? undo->bytes : 0;
+    if (m->bm_ver != tm->bookmarks.version) {
+        m->bookmarks = bookmarks_mem(&tm->bookmarks);
+        m->bm_ver = tm->bookmarks.version;
+    }
+    m->pred = pred_mem(&tm->pred);
+    if (!m->limit || mem_used(tm) <= m->limit) return;
+
+    // Measure every tab first (a save can cache a fragment without queueing
+    // the tab), then evict to the low mark so the next pass is a while away.
+    m->passes++;
+    size_t low = m->limit - m->limit / 8;
+    Victim *h = (Victim*)malloc((size_t)(tm->count + tm->pred.count + 1) * sizeof(Victim));
+    int n = 0;
+    for (int i = 0; i < tm->count; ++i) {
+        recharge(tm, tm->tabs[i]);
+        int64_t ts = browser_evict_ts(tm->tabs[i]);
+        if (ts != INT64_MAX) { h[n].ts = ts; h[n].b = tm->tabs[i]; h[n].r = NULL; n++; }
+    }
+    // rows with successors, each forgotten whole; the empty ones go with the last row pointing at them
+    for (int i = 0; i < tm->pred.rows.cap; ++i) {
+        if (!sm_live(&tm->pred.rows.slots[i])) continue;
+        PredRow *r = (PredRow*)tm->pred.rows.slots[i].val;
+        if (r->nnext) { h[n].ts = r->ts; h[n].b = NULL; h[n].r = r; n++; }
+    }
+    for (int i = n / 2 - 1; i >= 0; --i) victim_down(h, n, i);
+    while (n && mem_used(tm) > low) {
+        if (h[0].r) {
+            m->pred_dropped += pred_forget(&tm->pred, h[0].r);
+            m->pred = pred_mem(&tm->pred);
+            h[0] = h[--n];
+            victim_down(h, n, 0);
+            continue;
+        }
+        Browser *b = h[0].b;
+        int r = browser_evict(b);
+        if (r > 0) m->evicted += r;
+        else if (r < 0) m->spilled++;
+        recharge(tm, b);
+        int64_t ts = browser_evict_ts(b);
+        if (r == 0 || ts == INT64_MAX) h[0] = h[--n];   // 0: its cold tier could not take the entry
+        else h[0].ts = ts;
+        victim_down(h, n, 0);
+    }
+    free(h);
+    // history alone could not make room: the longest-closed tabs go next
+    while (undo && undo->blobs.size && mem_used(tm) > low) {
+        char *old = undo->blobs.data[0];
+        undo->bytes -= strlen(old) + 1;
+        free(old);
+        memmove(undo->blobs.data, undo->blobs.data + 1, (size_t)(--undo->blobs.size) * sizeof(char*));
+        m->undo = undo->bytes;
+        m->undo_dropped++;
+    }
+    settle_queue(tm);   // evicting queued those tabs again
+}
+
+// A slot is rewritten only when its tab changed (every history change bumps
+// the version; uids are never reused by a manager, loads included), so a
+// command that touches one tab rewrites one slot.
+static void view_tab(ShmViewTab *t, const Browser *b) {
+    if (t->uid == b->uid && t->version == b->version) return;
+    size_t n = strlen(b->current);
+    size_t k = n < SHMV_URL - 1 ? n : SHMV_URL - 1;
+    memcpy(t->url, b->current, k); t->url[k] = '\0';
+    t->url_len = (uint32_t)n;
+    t->back = browser_back_total(b); t->forward = b->fwd.size; t->ts = b->current_ts;
+    t->uid = b->uid; t->version = b->version;
+}
+
+void view_publish(TabManager *tm, const UndoStack *undo) {
+    TRACE_BEGIN(span, "view_publish");
+    ShmViewData *d = shmview_begin(tm->view);
+    d->live = 1;
+    d->updates++;
+    d->updated_ms = wall_ms();
+    d->count = tm->count; d->active = tm->active;
+    d->bookmarks = tm->bookmarks.size;
+    d->closed = undo ? undo->blobs.size : 0;
+    d->mem_used = mem_used(tm); d->mem_limit = tm->mem.limit;
+    d->evicted = tm->mem.evicted; d->spilled = tm->mem.spilled; d->undo_dropped = tm->mem.undo_dropped;
+    d->predicted = tm->pred.count;
+    for (int i = 0; i < tm->count && i < SHMV_TABS; ++i) view_tab(&d->tab[i], tm->tabs[i]);
+    shmview_end(tm->view);
+    TRACE_END(span);
+}
@@ -0,0 +1,136 @@
+#include <stdlib.h>
+#include <string.h>
+#include "hmap.h"
+#include "util.h"
+
+static const char SM_TOMB[1];   // address marks a deleted StrMap slot
+
+enum { UM_EMPTY = 0, UM_FULL = 1, UM_TOMB = 2 };
+
+// ---- StrMap ----
+void sm_init(StrMap *m){ m->slots=NULL; m->cap=m->count=m->used=0; }
+void sm_free(StrMap *m){ free(m->slots); sm_init(m); }
+int  sm_live(const SMSlot *s){ return s->key && s->key != SM_TOMB; }
+
+static void sm_rehash(StrMap *m, int nc){
+    SMSlot *old = m->slots; int oc = m->cap;
+    m->slots = (SMSlot*)calloc((size_t)nc, sizeof(SMSlot)); m->cap = nc; m->used = m->count;
+    for (int i=0;i<oc;++i){
+        if (!sm_live(&old[i])) continue;
+        int j = (int)(old[i].hash & (uint64_t)(nc-1));
+        while (m->slots[j].key) j = (j+1) & (nc-1);
+        m->slots[j] = old[i];
+    }
+    free(old);
+}
+
+static void sm_grow(StrMap *m){
+    // rehash when live + tombstones pass 3/4 of the table
+    if ((m->used + 1) * 4 < m->cap * 3) return;
+    int nc = m->cap ? m->cap : 16;
+    while ((m->count + 1) * 2 > nc) nc <<= 1;
+    sm_rehash(m, nc);
+}
+
+void sm_reserve(StrMap *m, int n){
+    int nc = m->cap ? m->cap : 16;
+    while ((m->count + n) * 2 > nc) nc <<= 1;
+    if (nc != m->cap) sm_rehash(m, nc);
+}
+
+static int sm_find(const StrMap *m, const char *key, uint64_t h){
+    if (!m->cap) return -1;
+    int j = (int)(h & (uint64_t)(m->cap-1));
+    while (m->slots[j].key){
+        if (m->slots[j].key != SM_TOMB && m->slots[j].hash == h && strcmp(m->slots[j].key, key) == 0) return j;
+        j = (j+1) & (m->cap-1);
+    }
+    return -1;
+}
+
+void **sm_get(const StrMap *m, const char *key){
+    int j = sm_find(m, key, fnv1a64(key, strlen(key), FNV1A64_SEED));
+    return j < 0 ? NULL : &m->slots[j].val;
+}
+
+void **sm_put(StrMap *m, const char *key, int *created){
+    uint64_t h = fnv1a64(key, strlen(key), FNV1A64_SEED);
+    int j = sm_find(m, key, h);
+    if (created) *created = (j < 0);
+    if (j >= 0) return &m->slots[j].val;
+    sm_grow(m);
+    j = (int)(h & (uint64_t)(m->cap-1));
+    while (sm_live(&m->slots[j])) j = (j+1) & (m->cap-1);
+    if (!m->slots[j].key) m->used++;
+    m->slots[j].key = key; m->slots[j].hash = h; m->slots[j].val = NULL;
+    m->count++;
+    return &m->slots[j].val;
+}
+
+int sm_del(StrMap *m, const char *key){
+    int j = sm_find(m, key, fnv1a64(key, strlen(key), FNV1A64_SEED));
+    if (j < 0) return 0;
+    m->slots[j].key = SM_TOMB; m->slots[j].val = NULL;
+    m->count--;
+    return 1;
+}
+
+// ---- U64Map ----
+static uint64_t um_mix(uint64_t k){
+    k ^= k >> 33; k *= 0xff51afd7ed558ccdULL; k ^= k >> 33; k *= 0xc4ceb9fe1a85ec53ULL; k ^= k >> 33;
+    return k;
+}
+
+void um_init(U64Map *m){ m->slots=NULL; m->cap=m->count=m->used=0; }
+void um_free(U64Map *m){ free(m->slots); um_init(m); }
+
+static void um_grow(U64Map *m){
+    if ((m->used + 1) * 4 < m->cap * 3) return;
+    int nc = m->cap ? m->cap : 16;
+    while ((m->count + 1) * 2 > nc) nc <<= 1;
+    UMSlot *old = m->slots; int oc = m->cap;
+    m->slots = (UMSlot*)calloc((size_t)nc, sizeof(UMSlot)); m->cap = nc; m->used = m->count;
+    for (int i=0;i<oc;++i){
+        if (old[i].state != UM_FULL) continue;
+        int j = (int)(um_mix(old[i].key) & (uint64_t)(nc-1));
+        while (m->slots[j].state) j = (j+1) & (nc-1);
+        m->slots[j] = old[i];
+    }
+    free(old);
+}
+
+static int um_find(const U64Map *m, uint64_t key){
+    if (!m->cap) return -1;
+    int j = (int)(um_mix(key) & (uint64_t)(m->cap-1));
+    while (m->slots[j].state){
+        if (m->slots[j].state == UM_FULL && m->slots[j].key == key) return j;
+        j = (j+1) & (m->cap-1);
+    }
+    return -1;
+}
+
+void **um_get(const U64Map *m, uint64_t key){
+    int j = um_find(m, key);
+    return j < 0 ? NULL : &m->slots[j].val;
+}
+
+void **um_put(U64Map *m, uint64_t key, int *created){
+    int j = um_find(m, key);
+    if (created) *created = (j < 0);
+    if (j >= 0) return &m->slots[j].val;
+    um_grow(m);
+    j = (int)(um_mix(key) & (uint64_t)(m->cap-1));
+    while (m->slots[j].state == UM_FULL) j = (j+1) & (m->cap-1);
+    if (m->slots[j].state == UM_EMPTY) m->used++;
+    m->slots[j].state = UM_FULL; m->slots[j].key = key; m->slots[j].val = NULL;
+    m->count++;
+    return &m->slots[j].val;
+}
+
+int um_del(U64Map *m, uint64_t key){
+    int j = um_find(m, key);
+    if (j < 0) return 0;
+    m->slots[j].state = UM_TOMB; m->slots[j].val = NULL;
+    m->count--;
+    return 1;
+}
@@ -0,0 +1,193 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "lz.h"
+
+#define LZ_WINDOW   65535u
+#define LZ_HBITS    14
+#define LZ_MINMATCH 4
+#define LZ_LASTLIT  8      // the codec always ends a block on literals
+
+// ---- little-endian helpers ----
+static void put32(unsigned char *p, uint32_t v){ p[0]=(unsigned char)v; p[1]=(unsigned char)(v>>8); p[2]=(unsigned char)(v>>16); p[3]=(unsigned char)(v>>24); }
+static uint32_t get32(const unsigned char *p){ return (uint32_t)p[0] | (uint32_t)p[1]<<8 | (uint32_t)p[2]<<16 | (uint32_t)p[3]<<24; }
+static uint32_t read32(const unsigned char *p){ uint32_t v; memcpy(&v, p, 4); return v; }
+static uint32_t lz_hash(uint32_t v){ return (v * 2654435761u) >> (32 - LZ_HBITS); }
+
+static unsigned char *put_len(unsigned char *op, size_t n){
+    while (n >= 255){ *op++ = 255; n -= 255; }
+    *op++ = (unsigned char)n;
+    return op;
+}
+
+static unsigned char *put_seq(unsigned char *op, const unsigned char *lit, size_t nlit, uint32_t off, size_t mlen){
+    unsigned char *tok = op++;
+    *tok = (unsigned char)((nlit >= 15 ? 15 : nlit) << 4);
+    if (nlit >= 15) op = put_len(op, nlit - 15);
+    memcpy(op, lit, nlit); op += nlit;
+    if (!mlen) return op;
+    *op++ = (unsigned char)off; *op++ = (unsigned char)(off >> 8);
+    size_t m = mlen - LZ_MINMATCH;
+    *tok |= (unsigned char)(m >= 15 ? 15 : m);
+    if (m >= 15) op = put_len(op, m - 15);
+    return op;
+}
+
+// compress win[start, end); matches may start anywhere in win[0, end)
+static size_t lz_compress(const unsigned char *win, size_t start, size_t end, unsigned char *dst, int32_t *htab){
+    unsigned char *op = dst;
+    size_t ip = start, anchor = start;
+    size_t limit = end > LZ_LASTLIT + LZ_MINMATCH ? end - LZ_LASTLIT - LZ_MINMATCH : 0;
+    while (ip < limit){
+        uint32_t seq = read32(win + ip), h = lz_hash(seq);
+        int32_t ref = htab[h];
+        htab[h] = (int32_t)ip;
+        if (ref < 0 || ip - (size_t)ref > LZ_WINDOW || read32(win + ref) != seq){ ip++; continue; }
+        size_t len = LZ_MINMATCH;
+        while (ip + len < end - LZ_LASTLIT && win[ref + len] == win[ip + len]) len++;
+        op = put_seq(op, win + anchor, ip - anchor, (uint32_t)(ip - (size_t)ref), len);
+        ip += len; anchor = ip;
+    }
+    return (size_t)(put_seq(op, win + anchor, end - anchor, 0, 0) - dst);
+}
+
+// ---- writer ----
+struct LzWriter {
+    FILE *f;
+    int ok;
+    size_t hist;                         // bytes of history before the current block
+    size_t fill;                         // bytes in the current block
+    int32_t htab[1 << LZ_HBITS];
+    unsigned char win[2 * LZ_BLOCK];     // [history 64K][current block]
+    unsigned char out[8 + LZ_BLOCK + LZ_BLOCK / 255 + 64];
+};
+
+LzWriter *lzw_open(FILE *f){
+    LzWriter *w = (LzWriter*)malloc(sizeof(LzWriter));
+    if (!w) return NULL;
+    w->f = f; w->ok = fwrite(LZ_MAGIC, 1, LZ_MAGIC_LEN, f) == LZ_MAGIC_LEN;
+    w->hist = 0; w->fill = 0;
+    for (int i=0;i<(1 << LZ_HBITS);++i) w->htab[i] = -1;
+    return w;
+}
+
+static void lzw_flush(LzWriter *w){
+    if (!w->fill) return;
+    size_t start = LZ_BLOCK, end = LZ_BLOCK + w->fill;
+    size_t n = lz_compress(w->win, start, end, w->out + 8, w->htab);
+    uint32_t stored = (uint32_t)n;
+    if (n >= w->fill){   // incompressible: store as is
+        memcpy(w->out + 8, w->win + start, w->fill);
+        n = w->fill; stored = (uint32_t)n | 0x80000000u;
+    }
+    put32(w->out, (uint32_t)w->fill); put32(w->out + 4, stored);
+    if (fwrite(w->out, 1, 8 + n, w->f) != 8 + n) w->ok = 0;
+    // slide: the last 64K of history + block become the next block's history
+    size_t keep = w->hist + w->fill < LZ_BLOCK ? w->hist + w->fill : LZ_BLOCK;
+    size_t shift = end - keep;   // win[shift, end) -> win[LZ_BLOCK - keep, LZ_BLOCK)
+    size_t dst = LZ_BLOCK - keep;
+    memmove(w->win + dst, w->win + shift, keep);
+    long delta = (long)shift - (long)dst;
+    for (int i=0;i<(1 << LZ_HBITS);++i){
+        if (w->htab[i] < 0) continue;
+        long p = (long)w->htab[i] - delta;
+        w->htab[i] = p >= (long)dst ? (int32_t)p : -1;
+    }
+    w->hist = keep; w->fill = 0;
+}
+
+int lzw_write(LzWriter *w, const void *p, size_t n){
+    const unsigned char *s = (const unsigned char*)p;
+    while (n){
+        size_t k = LZ_BLOCK - w->fill; if (k > n) k = n;
+        memcpy(w->win + LZ_BLOCK + w->fill, s, k);
+        w->fill += k; s += k; n -= k;
+        if (w->fill == LZ_BLOCK) lzw_flush(w);
+    }
+    return w->ok;
+}
+
+int lzw_close(LzWriter *w){
+    lzw_flush(w);
+    unsigned char end[8] = {0};
+    if (fwrite(end, 1, 8, w->f) != 8) w->ok = 0;
+    int ok = w->ok;
+    free(w);
+    return ok;
+}
+
+// ---- reader ----
+struct LzReader {
+    FILE *f;
+    int err, eof;
+    size_t hist;                         // valid history bytes before LZ_BLOCK
+    size_t pos, fill;                    // unread bytes are win[LZ_BLOCK + pos, LZ_BLOCK + fill)
+    unsigned char win[2 * LZ_BLOCK];
+    unsigned char in[LZ_BLOCK + LZ_BLOCK / 255 + 64];
+};
+
+LzReader *lzr_open(FILE *f){
+    LzReader *r = (LzReader*)calloc(1, sizeof(LzReader));
+    if (r) r->f = f;
+    return r;
+}
+
+int  lzr_error(const LzReader *r){ return r->err; }
+void lzr_close(LzReader *r){ free(r); }
+
+static int lz_decompress(const unsigned char *ip, size_t n, unsigned char *win, size_t start, size_t hist, size_t raw){
+    const unsigned char *iend = ip + n;
+    size_t op = start, oend = start + raw, lo = start - hist;
+    while (ip < iend){
+        unsigned tok = *ip++;
+        size_t lit = tok >> 4;
+        if (lit == 15){ unsigned b; do { if (ip >= iend) return 0; b = *ip++; lit += b; } while (b == 255); }
+        if ((size_t)(iend - ip) < lit || oend - op < lit) return 0;
+        memcpy(win + op, ip, lit); ip += lit; op += lit;
+        if (ip >= iend) break;                       // final literal run
+        if (iend - ip < 2) return 0;
+        size_t off = (size_t)ip[0] | (size_t)ip[1] << 8; ip += 2;
+        size_t m = tok & 15;
+        if (m == 15){ unsigned b; do { if (ip >= iend) return 0; b = *ip++; m += b; } while (b == 255); }
+        m += LZ_MINMATCH;
+        if (off == 0 || off > op - lo || oend - op < m) return 0;
+        for (size_t i=0;i<m;++i,++op) win[op] = win[op - off];   // may overlap
+    }
+    return op == oend;
+}
+
+static int lzr_next_block(LzReader *r){
+    unsigned char hdr[8];
+    if (fread(hdr, 1, 8, r->f) != 8){ r->err = 1; return 0; }
+    uint32_t raw = get32(hdr), stored = get32(hdr + 4);
+    if (raw == 0){ r->eof = 1; return 0; }
+    size_t n = stored & 0x7fffffffu;
+    if (raw > LZ_BLOCK || n > sizeof r->in){ r->err = 1; return 0; }
+    // slide history first so matches can reach into the previous block
+    size_t keep = r->hist + r->fill < LZ_BLOCK ? r->hist + r->fill : LZ_BLOCK;
+    memmove(r->win + LZ_BLOCK - keep, r->win + LZ_BLOCK + r->fill - keep, keep);
+    r->hist = keep; r->pos = r->fill = 0;
+    if (fread(r->in, 1, n, r->f) != n){ r->err = 1; return 0; }
+    if (stored & 0x80000000u){
+        if (n != raw){ r->err = 1; return 0; }
+        memcpy(r->win + LZ_BLOCK, r->in, n);
+    } else if (!lz_decompress(r->in, n, r->win, LZ_BLOCK, r->hist, raw)){
+        r->err = 1; return 0;
+    }
+    r->fill = raw;
+    return 1;
+}
+
+size_t lzr_read(LzReader *r, void *p, size_t n){
+    unsigned char *d = (unsigned char*)p;
+    size_t got = 0;
+    while (got < n){
+        if (r->pos == r->fill){
+            if (r->eof || r->err || !lzr_next_block(r)) break;
+        }
+        size_t k = r->fill - r->pos; if (k > n - got) k = n - got;
+        memcpy(d + got, r->win + LZ_BLOCK + r->pos, k);
+        r->pos += k; got += k;
+    }
+    return got;
+}
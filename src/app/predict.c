@@ -0,0 +1,88 @@
+#include <stdlib.h>
+#include <string.h>
+#include "predict.h"
+#include "util.h"
+
+void pred_init(Predictor *p) {
+    sm_init(&p->rows);
+    p->count = 0;
+    p->version = 0;
+    p->bytes = 0;
+}
+
+void pred_free(Predictor *p) {
+    for (int i = 0; i < p->rows.cap; ++i) {
+        if (!sm_live(&p->rows.slots[i])) continue;
+        PredRow *r = (PredRow*)p->rows.slots[i].val;
+        free(r->url); free(r);
+    }
+    sm_free(&p->rows);
+    pred_init(p);
+}
+
+static size_t row_mem(const PredRow *r) { return sizeof(PredRow) + strlen(r->url) + 1; }
+
+PredRow *pred_row(Predictor *p, const char *url) {
+    void **s = sm_get(&p->rows, url);
+    if (s) return (PredRow*)*s;
+    PredRow *r = (PredRow*)calloc(1, sizeof(PredRow));
+    r->url = sdup(url);
+    *sm_put(&p->rows, r->url, NULL) = r;
+    p->count++;
+    p->bytes += row_mem(r);
+    return r;
+}
+
+const PredRow *pred_get(const Predictor *p, const char *url) {
+    void **s = sm_get(&p->rows, url);
+    return s ? (const PredRow*)*s : NULL;
+}
+
+static void row_free(Predictor *p, PredRow *r) {
+    sm_del(&p->rows, r->url);
+    p->count--;
+    p->bytes -= row_mem(r);
+    free(r->url); free(r);
+}
+
+// a successor slot lets go of its row; an empty row nobody points at goes
+static int row_unref(Predictor *p, PredRow *r) {
+    if (--r->refs > 0 || r->nnext) return 0;
+    row_free(p, r);
+    return 1;
+}
+
+void pred_visit(Predictor *p, const char *from, const char *to, int64_t ts) {
+    if (strcmp(from, to) == 0) return;   // a reload says nothing about where to go next
+    PredRow *a = pred_row(p, from), *b = pred_row(p, to);
+    int i = 0;
+    while (i < a->nnext && a->next[i].to != b) i++;
+    if (i == a->nnext) {
+        if (a->nnext < PRED_K) { a->nnext++; a->next[i].n = a->next[i].err = 0; }
+        else { i = PRED_K - 1; a->next[i].err = a->next[i].n; row_unref(p, a->next[i].to); }   // evict the minimum, keep its count
+        a->next[i].to = b;
+        b->refs++;
+    }
+    a->next[i].n++;
+    a->total++;
+    for (; i > 0 && a->next[i].n > a->next[i - 1].n; --i) {
+        PredNext t = a->next[i]; a->next[i] = a->next[i - 1]; a->next[i - 1] = t;
+    }
+    a->ts = ts;
+    p->version++;
+}
+
+size_t pred_mem(const Predictor *p) {
+    return p->bytes + (size_t)p->rows.cap * sizeof(SMSlot);
+}
+
+// Only empty rows are freed along the way, so a caller walking rows with
+// successors (mem_settle's heap) never meets a freed one.
+int pred_forget(Predictor *p, PredRow *r) {
+    int gone = 0;
+    for (int i = 0; i < r->nnext; ++i) gone += row_unref(p, r->next[i].to);
+    r->nnext = 0; r->total = 0;
+    if (!r->refs) { row_free(p, r); gone++; }
+    p->version++;
+    return gone;
+}
@@ -0,0 +1,197 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "search.h"
+#include "browser.h"
+#include "util.h"
+
+static uint32_t tri_key(const char *p){
+    return ((uint32_t)tolower((unsigned char)p[0]) << 16 |
+            (uint32_t)tolower((unsigned char)p[1]) << 8  |
+            (uint32_t)tolower((unsigned char)p[2])) + 1;
+}
+
+static uint64_t ref_key(int doc, const struct Browser *tab){
+    return (uint64_t)(uint32_t)doc << 32 | (tab ? tab->uid : 0u);
+}
+
+// ---- trigram table ----
+static uint32_t tri_hash(uint32_t k){ k *= 0x9E3779B1u; return k ^ (k >> 15); }
+
+static Posting *tri_find(const UrlIndex *ix, uint32_t key){
+    if (!ix->tcap) return NULL;
+    uint32_t j = tri_hash(key) & (uint32_t)(ix->tcap-1);
+    while (ix->tri[j].key){
+        if (ix->tri[j].key == key) return &ix->tri[j].post;
+        j = (j+1) & (uint32_t)(ix->tcap-1);
+    }
+    return NULL;
+}
+
+static Posting *tri_put(UrlIndex *ix, uint32_t key){
+    if ((ix->tcount + 1) * 2 > ix->tcap){
+        int nc = ix->tcap ? ix->tcap * 2 : 1024;
+        TriSlot *old = ix->tri; int oc = ix->tcap;
+        ix->tri = (TriSlot*)calloc((size_t)nc, sizeof(TriSlot)); ix->tcap = nc;
+        for (int i=0;i<oc;++i){
+            if (!old[i].key) continue;
+            uint32_t j = tri_hash(old[i].key) & (uint32_t)(nc-1);
+            while (ix->tri[j].key) j = (j+1) & (uint32_t)(nc-1);
+            ix->tri[j] = old[i];
+        }
+        free(old);
+    }
+    uint32_t j = tri_hash(key) & (uint32_t)(ix->tcap-1);
+    while (ix->tri[j].key && ix->tri[j].key != key) j = (j+1) & (uint32_t)(ix->tcap-1);
+    if (!ix->tri[j].key){ ix->tri[j].key = key; ix->tcount++; }
+    return &ix->tri[j].post;
+}
+
+static void tri_index_doc(UrlIndex *ix, int id){
+    const char *u = ix->docs[id].url;
+    size_t n = strlen(u);
+    for (size_t i=0; i+3<=n; ++i){
+        Posting *p = tri_put(ix, tri_key(u+i));
+        if (p->n && p->ids[p->n-1] == id) continue;   // repeated trigram in this url
+        if (p->n == p->cap){ p->cap = p->cap ? p->cap*2 : 4; p->ids = (int*)realloc(p->ids, (size_t)p->cap*sizeof(int)); }
+        p->ids[p->n++] = id;
+    }
+}
+
+// ---- lifecycle ----
+void urlidx_init(UrlIndex *ix){
+    sm_init(&ix->by_url); um_init(&ix->refpos);
+    ix->docs=NULL; ix->ndocs=ix->cdocs=ix->ndead=0;
+    ix->tri=NULL; ix->tcap=ix->tcount=0;
+}
+
+void urlidx_free(UrlIndex *ix){
+    for (int i=0;i<ix->ndocs;++i){ free(ix->docs[i].url); free(ix->docs[i].refs); }
+    for (int i=0;i<ix->tcap;++i) free(ix->tri[i].post.ids);
+    free(ix->docs); free(ix->tri);
+    sm_free(&ix->by_url); um_free(&ix->refpos);
+    urlidx_init(ix);
+}
+
+// drop dead documents and renumber once they outweigh the live ones
+static void urlidx_compact(UrlIndex *ix){
+    if (ix->ndead < 1024 || ix->ndead * 2 < ix->ndocs) return;
+    for (int i=0;i<ix->tcap;++i){ free(ix->tri[i].post.ids); }
+    free(ix->tri); ix->tri=NULL; ix->tcap=ix->tcount=0;
+    um_free(&ix->refpos);
+    int k = 0;
+    for (int i=0;i<ix->ndocs;++i){
+        if (!ix->docs[i].url) continue;
+        ix->docs[k] = ix->docs[i];
+        *sm_get(&ix->by_url, ix->docs[k].url) = (void*)(intptr_t)(k+1);
+        for (int r=0;r<ix->docs[k].nrefs;++r)
+            *um_put(&ix->refpos, ref_key(k, ix->docs[k].refs[r].tab), NULL) = (void*)(intptr_t)(r+1);
+        ++k;
+    }
+    ix->ndocs = k; ix->ndead = 0;
+    for (int i=0;i<k;++i) tri_index_doc(ix, i);
+}
+
+const char *urlidx_add(UrlIndex *ix, struct Browser *tab, const char *url){
+    if (!url) return NULL;
+    int created;
+    void **slot = sm_get(&ix->by_url, url);
+    int id;
+    if (slot) id = (int)(intptr_t)*slot - 1;
+    else {
+        if (ix->ndocs == ix->cdocs){ ix->cdocs = ix->cdocs ? ix->cdocs*2 : 64; ix->docs = (UrlDoc*)realloc(ix->docs, (size_t)ix->cdocs*sizeof(UrlDoc)); }
+        id = ix->ndocs++;
+        UrlDoc *d = &ix->docs[id];
+        d->url = sdup(url); d->refs = NULL; d->nrefs = d->crefs = 0;
+        *sm_put(&ix->by_url, d->url, NULL) = (void*)(intptr_t)(id+1);
+        tri_index_doc(ix, id);
+    }
+    UrlDoc *d = &ix->docs[id];
+    void **rp = um_put(&ix->refpos, ref_key(id, tab), &created);
+    if (!created){ d->refs[(intptr_t)*rp - 1].count++; return d->url; }
+    if (d->nrefs == d->crefs){ d->crefs = d->crefs ? d->crefs*2 : 2; d->refs = (UrlRef*)realloc(d->refs, (size_t)d->crefs*sizeof(UrlRef)); }
+    d->refs[d->nrefs].tab = tab; d->refs[d->nrefs].count = 1;
+    *rp = (void*)(intptr_t)(++d->nrefs);
+    return d->url;
+}
+
+void urlidx_remove(UrlIndex *ix, struct Browser *tab, const char *url){
+    if (!url) return;
+    void **slot = sm_get(&ix->by_url, url);
+    if (!slot) return;
+    int id = (int)(intptr_t)*slot - 1;
+    UrlDoc *d = &ix->docs[id];
+    void **rp = um_get(&ix->refpos, ref_key(id, tab));
+    if (!rp) return;
+    int r = (int)(intptr_t)*rp - 1;
+    if (--d->refs[r].count > 0) return;
+    um_del(&ix->refpos, ref_key(id, tab));
+    if (r != d->nrefs - 1){   // swap-remove, keep the moved ref's slot current
+        d->refs[r] = d->refs[d->nrefs - 1];
+        *um_get(&ix->refpos, ref_key(id, d->refs[r].tab)) = (void*)(intptr_t)(r+1);
+    }
+    if (--d->nrefs > 0) return;
+    // last holder gone: the doc dies, its postings are skipped until compaction
+    sm_del(&ix->by_url, d->url);
+    free(d->url); free(d->refs);
+    d->url = NULL; d->refs = NULL; d->crefs = 0;
+    ix->ndead++;
+    urlidx_compact(ix);
+}
+
+// ---- query ----
+static int ci_contains(const char *hay, const char *needle, size_t n){
+    for (; *hay; ++hay){
+        size_t i = 0;
+        while (i < n && hay[i] && tolower((unsigned char)hay[i]) == tolower((unsigned char)needle[i])) ++i;
+        if (i == n) return 1;
+    }
+    return 0;
+}
+
+static int has_id(const Posting *p, int id){
+    int lo = 0, hi = p->n - 1;
+    while (lo <= hi){
+        int mid = (lo + hi) / 2;
+        if (p->ids[mid] == id) return 1;
+        if (p->ids[mid] < id) lo = mid + 1; else hi = mid - 1;
+    }
+    return 0;
+}
+
+static void emit_doc(const UrlDoc *d, UrlHit **out, int *n, int *cap){
+    for (int r=0;r<d->nrefs;++r){
+        if (*n == *cap){ *cap = *cap ? *cap*2 : 16; *out = (UrlHit*)realloc(*out, (size_t)*cap*sizeof(UrlHit)); }
+        (*out)[*n].tab = d->refs[r].tab; (*out)[*n].url = d->url; (*n)++;
+    }
+}
+
+int urlidx_search(const UrlIndex *ix, const char *sub, UrlHit **out){
+    *out = NULL;
+    int n = 0, cap = 0;
+    size_t len = strlen(sub);
+    if (len < 3){   // too short for trigrams: scan the documents
+        for (int i=0;i<ix->ndocs;++i)
+            if (ix->docs[i].url && ci_contains(ix->docs[i].url, sub, len)) emit_doc(&ix->docs[i], out, &n, &cap);
+        return n;
+    }
+    int nt = (int)(len - 2);
+    const Posting **lists = (const Posting**)calloc((size_t)nt, sizeof(Posting*));
+    for (int i=0;i<nt;++i){
+        lists[i] = tri_find(ix, tri_key(sub+i));
+        if (!lists[i] || !lists[i]->n){ free(lists); return 0; }
+    }
+    // walk the shortest list, probe the rest
+    int best = 0;
+    for (int i=1;i<nt;++i) if (lists[i]->n < lists[best]->n) best = i;
+    for (int k=0;k<lists[best]->n;++k){
+        int id = lists[best]->ids[k];
+        const UrlDoc *d = &ix->docs[id];
+        if (!d->url) continue;
+        int ok = 1;
+        for (int i=0;i<nt && ok;++i) if (i != best && !has_id(lists[i], id)) ok = 0;
+        if (ok && ci_contains(d->url, sub, len)) emit_doc(d, out, &n, &cap);
+    }
+    free(lists);
+    return n;
+}
@@ -0,0 +1,116 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sessdiff.h"
+#include "session.h"
+#include "hmap.h"
+
+// Chains the tabs of one side by key: the map holds the first id + 1 and
+// next[] the id + 1 that follows it, so equal keys pop out in id order.
+static void bucket(U64Map *m, int *next, const uint64_t *key, const int *partner, int n){
+    for (int i = n - 1; i >= 0; --i){
+        if (partner[i] >= 0) continue;
+        int created;
+        void **s = um_put(m, key[i], &created);
+        next[i] = created ? 0 : (int)(intptr_t)*s;
+        *s = (void*)(intptr_t)(i + 1);
+    }
+}
+
+static int pop(U64Map *m, const int *next, uint64_t key){
+    void **s = um_get(m, key);
+    if (!s || !*s) return -1;
+    int i = (int)(intptr_t)*s - 1;
+    *s = (void*)(intptr_t)next[i];
+    return i;
+}
+
+// Pairs unpaired a-tabs with unpaired b-tabs of the same key.
+static void pair_by(const uint64_t *ka, int na, const uint64_t *kb, int nb, int *pa, int *pb, int *next){
+    U64Map m; um_init(&m);
+    bucket(&m, next, kb, pb, nb);
+    for (int i = 0; i < na; ++i){
+        if (pa[i] >= 0) continue;
+        int j = pop(&m, next, ka[i]);
+        if (j >= 0){ pa[i] = j; pb[j] = i; }
+    }
+    um_free(&m);
+}
+
+void session_diff(TabManager *a, TabManager *b, SessionDiff *d){
+    int na = a->count, nb = b->count, nmin = na < nb ? na : nb;
+    memset(d, 0, sizeof *d);
+    d->same    = (TabPair*)malloc((size_t)(nmin + 1) * sizeof(TabPair));
+    d->changed = (TabPair*)malloc((size_t)(nmin + 1) * sizeof(TabPair));
+    d->only_a  = (int*)malloc((size_t)(na + 1) * sizeof(int));
+    d->only_b  = (int*)malloc((size_t)(nb + 1) * sizeof(int));
+
+    uint64_t *ka = (uint64_t*)calloc((size_t)na + 1, sizeof(uint64_t)), *kb = (uint64_t*)calloc((size_t)nb + 1, sizeof(uint64_t));
+    int *pa = (int*)malloc((size_t)(na + 1) * sizeof(int)), *pb = (int*)malloc((size_t)(nb + 1) * sizeof(int));
+    int *next = (int*)malloc((size_t)(nb + 1) * sizeof(int));
+    for (int i = 0; i < na; ++i) pa[i] = -1;
+    for (int j = 0; j < nb; ++j) pb[j] = -1;
+
+    // the same tab on both sides first, then the leftovers with identical
+    // histories (tabs from files written before tab ids, duplicates)
+    for (int i = 0; i < na; ++i) ka[i] = a->tabs[i]->tab_id;
+    for (int j = 0; j < nb; ++j) kb[j] = b->tabs[j]->tab_id;
+    pair_by(ka, na, kb, nb, pa, pb, next);
+    for (int i = 0; i < na; ++i) ka[i] = browser_hash(a->tabs[i]);
+    for (int j = 0; j < nb; ++j) kb[j] = browser_hash(b->tabs[j]);
+    pair_by(ka, na, kb, nb, pa, pb, next);
+
+    for (int i = 0; i < na; ++i){
+        int j = pa[i];
+        if (j < 0){ d->only_a[d->nonly_a++] = i; continue; }
+        TabPair *p = ka[i] == kb[j] ? &d->same[d->nsame++] : &d->changed[d->nchanged++];
+        p->a = i; p->b = j;
+    }
+    for (int j = 0; j < nb; ++j) if (pb[j] < 0) d->only_b[d->nonly_b++] = j;
+
+    free(ka); free(kb);
+    free(pa); free(pb); free(next);
+}
+
+void session_diff_free(SessionDiff *d){
+    free(d->same); free(d->changed); free(d->only_a); free(d->only_b);
+    memset(d, 0, sizeof *d);
+}
+
+int session_load_scratch(const char *path, TabManager *out){
+    tm_init(out, SP_UNBOUNDED);
+    out->unindexed = 1;
+    return load_session_json(path, out, SP_UNBOUNDED);
+}
+
+void session_merge(TabManager *live, TabManager *from, const SessionDiff *d,
+                   int prune, UndoStack *undo, MergeStats *st){
+    memset(st, 0, sizeof *st);
+    // changed tabs keep their slot; replacing does not move any ids
+    for (int i = 0; i < d->nchanged; ++i){
+        int a = d->changed[i].a, b = d->changed[i].b;
+        if (browser_last_ts(from->tabs[b]) > browser_last_ts(live->tabs[a])){
+            if (undo) undo_push_tab(undo, live->tabs[a]);   // `reopen` brings the overwritten side back
+            tm_replace_tab(live, a, from->tabs[b]);
+            from->tabs[b] = NULL;
+            st->updated++;
+        } else st->kept++;
+    }
+    // only_a is in id order: close from the highest so the rest stay valid
+    for (int i = prune ? d->nonly_a - 1 : -1; i >= 0; --i){
+        int a = d->only_a[i];
+        if (undo) undo_push_tab(undo, live->tabs[a]);
+        tm_close_tab(live, a);
+        st->pruned++;
+    }
+    for (int i = 0; i < d->nonly_b; ++i){
+        int b = d->only_b[i];
+        tm_adopt_tab(live, from->tabs[b]);
+        from->tabs[b] = NULL;
+        st->added++;
+    }
+    int k = 0;
+    for (int i = 0; i < from->count; ++i)
+        if (from->tabs[i]){ from->tabs[k] = from->tabs[i]; from->tabs[k]->id = k; k++; }
+    from->count = k;
+    from->active = k ? 0 : -1;
+}
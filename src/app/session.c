@@ -2,204 +2,676 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#if defined(_WIN32) || defined(_WIN64)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 #include "session.h"
 #include "bookmarks.h"
 #include "util.h"
+#include "lz.h"
+#include "trace.h"
 
 /* forward declaration for internal helper */
 static void json_escape_str_mem(char **pbuf, size_t *plen, size_t *pcap, const char *s);
+static void json_ts_list_mem(char **pbuf, size_t *plen, size_t *pcap, const int64_t *v, int n, int64_t base);
+static void json_branch_mem(char **pbuf, size_t *plen, size_t *pcap, const Branch *br, int with_id, int64_t at_base);
 
 
+/* Cold-tier back entries are read in pages so a deep history never has to be
+   resident in full while it is written out. */
+static int cold_page(const Browser *b, int from, StrPack *page) {
+    sp_clear(page);
+    if (!b->cold || from >= b->cold->count) return 0;
+    int n = b->cold->count - from; if (n > COLD_PAGE) n = COLD_PAGE;
+    return cold_read_range(b->cold, from, n, page) ? n : 0;
+}
+
 /*  JSON writer  */
-static void json_escape_str(FILE *f, const char *s) {
-    fputc('"', f);
-    for (const unsigned char *p=(const unsigned char*)s; *p; ++p) {
-        unsigned char c = *p;
-        switch (c) {
-            case '\\': fputs("\\\\", f); break;
-            case '"': fputs("\\\"", f); break;
-            case '\n': fputs("\\n", f); break;
-            case '\r': fputs("\\r", f); break;
-            case '\t': fputs("\\t", f); break;
-            default:
-                if (c < 0x20) fprintf(f, "\\u%04x", c);
-                else fputc((int)c, f);
-        }
+
+/* Each tab's JSON object is cached on the Browser and reused until the tab's
+   version moves on, so a save only re-serializes the tabs that changed and
+   copies the cached bytes for the rest. */
+static char *serialize_tab(const Browser *b, size_t *plen, int inline_branches);
+
+const char *session_tab_fragment(Browser *b, size_t *len) {
+    if (!b->frag || b->frag_ver != b->version) {
+        free(b->frag);
+        b->frag = serialize_tab(b, &b->frag_len, 0);
+        b->frag_ver = b->version;
     }
-    fputc('"', f);
+    if (len) *len = b->frag_len;
+    return b->frag;
 }
 
-int save_session_json(const char *path, const TabManager *tm) {
+/* A branch never changes once archived, so its entry in the session's
+   branch table is serialized once and kept until the branch goes. */
+static const char *branch_fragment(Branch *br, size_t *len) {
+    if (!br->frag) {
+        size_t cap = 256;
+        br->frag_len = 0;
+        br->frag = (char*)malloc(cap);
+        json_branch_mem(&br->frag, &br->frag_len, &cap, br, 1, 0);
+    }
+    *len = br->frag_len;
+    return br->frag;
+}
+
+/* Bookmarks are cached the same way, keyed by the list's version. */
+static char *serialize_bookmarks(const BMList *bm, size_t *plen);
+
+static const char *bookmarks_fragment(BMList *bm, size_t *len) {
+    if (!bm->frag || bm->frag_ver != bm->version) {
+        free(bm->frag);
+        bm->frag = serialize_bookmarks(bm, &bm->frag_len);
+        bm->frag_ver = bm->version;
+    }
+    *len = bm->frag_len;
+    return bm->frag;
+}
+
+/* The next-visit model is not cached: every visit changes it, so only
+   explicit saves and the last autosave at exit write it. */
+static char *serialize_predictor(const Predictor *pr, size_t *plen);
+
+/* Output sink: the file itself, or the LZ container streamed into it when
+   the path ends in ".lz" (e.g. session.json.lz). */
+typedef struct { FILE *f; LzWriter *lz; int ok; } JOut;
+
+static void jout_write(JOut *o, const void *p, size_t n) {
+    if (o->lz) { if (!lzw_write(o->lz, p, n)) o->ok = 0; }
+    else if (fwrite(p, 1, n, o->f) != n) o->ok = 0;
+}
+static void jout_puts(JOut *o, const char *s) { jout_write(o, s, strlen(s)); }
+
+int session_path_compressed(const char *path) {
+    size_t n = strlen(path);
+    return n >= 3 && strcmp(path + n - 3, ".lz") == 0;
+}
+
+static int write_session(const char *path, const TabManager *tm, int with_model) {
     FILE *f = fopen(path, "wb");
     if (!f) return 0;
-
-    fputs("{\"tabs\":[", f);
+    JOut o = { f, NULL, 1 };
+    if (session_path_compressed(path) && !(o.lz = lzw_open(f))) { fclose(f); return 0; }
+
+    // the branch table comes first, each branch once however many tabs hold
+    // it, so a loader has them all by the time a tab names one
+    U64Map seen; um_init(&seen);
+    for (int i = 0; i < tm->count; ++i)
+        for (int j = 0; j < tm->tabs[i]->nbranches; ++j) {
+            Branch *br = tm->tabs[i]->branches[j];
+            int created; um_put(&seen, br->id, &created);
+            if (!created) continue;
+            size_t n; const char *frag = branch_fragment(br, &n);
+            jout_puts(&o, seen.count == 1 ? "{\"branches\":[" : ",");
+            jout_write(&o, frag, n);
+        }
+    jout_puts(&o, seen.count ? "],\"tabs\":[" : "{\"tabs\":[");
+    um_free(&seen);
     for (int i = 0; i < tm->count; ++i) {
-        const Browser *b = tm->tabs[i];
-        if (i) fputc(',', f);
-        fputc('{', f);
+        size_t n; const char *frag = session_tab_fragment(tm->tabs[i], &n);
+        if (i) jout_puts(&o, ",");
+        jout_write(&o, frag, n);
+    }
+    jout_puts(&o, "]");
+    if (tm->bookmarks.size) {   // the cache is the only thing written through the cast
+        size_t n; const char *frag = bookmarks_fragment((BMList*)&tm->bookmarks, &n);
+        jout_puts(&o, ",\"bookmarks\":");
+        jout_write(&o, frag, n);
+    }
+    if (with_model && tm->pred.count) {
+        size_t n; char *model = serialize_predictor(&tm->pred, &n);
+        jout_puts(&o, ",\"predict\":");
+        jout_write(&o, model, n);
+        free(model);
+    }
+    char tail[64];
+    snprintf(tail, sizeof tail, ",\"active\":%d}\n", tm->active < 0 ? 0 : tm->active);
+    jout_puts(&o, tail);
+    if (o.lz && !lzw_close(o.lz)) o.ok = 0;
+    if (fclose(f) != 0) o.ok = 0;
+    return o.ok;
+}
 
-        fputs("\"current\":", f);
-        json_escape_str(f, b->current);
+int save_session_json(const char *path, const TabManager *tm) {
+    TRACE_BEGIN(span, "save_session_json");
+    int ok = write_session(path, tm, 1);
+    TRACE_END_ARG(span, path);
+    return ok;
+}
 
-        fputs(",\"back\":[", f);
-        for (int j = 0; j < b->back.size; ++j) {
-            if (j) fputc(',', f);
-            json_escape_str(f, ring_at(&b->back, j));
-        }
-        fputc(']', f);
+int save_session_json_nomodel(const char *path, const TabManager *tm) {
+    TRACE_BEGIN(span, "save_session_json_nomodel");
+    int ok = write_session(path, tm, 0);
+    TRACE_END_ARG(span, path);
+    return ok;
+}
 
-        fputs(",\"forward\":[", f);
-        for (int j = 0; j < b->fwd.size; ++j) {
-            if (j) fputc(',', f);
-            json_escape_str(f, b->fwd.data[j]);
-        }
-        fputc(']', f);
+/*  Incremental JSON reader  */
+
+/* The loader is fed bytes in whatever pieces they arrive in (file chunks,
+   LZ blocks, a pipe) and never needs the whole document: a resumable lexer
+   turns bytes into events, and a schema builder turns events into tabs and
+   bookmarks as soon as each one is complete. Only the string currently being
+   lexed is buffered. */
+
+#define LOAD_CHUNK (64 * 1024)
+#define LEX_DEPTH  16
+
+enum { EV_BEGIN_OBJ, EV_END_OBJ, EV_BEGIN_ARR, EV_END_ARR, EV_KEY, EV_STRING, EV_NUMBER };
+enum { L_WS, L_STR, L_ESC, L_UESC, L_NUM };                             // lexer state
+enum { X_VALUE, X_VALUE_OR_END, X_KEY, X_KEY_OR_END, X_COLON, X_NEXT, X_DONE };  // what may come next
+enum { S_START, S_ROOT, S_TABS, S_TAB, S_TAB_LIST, S_TAB_TS, S_BRTABLE, S_BRANCHES, S_BRANCH,
+       S_BMS, S_BM, S_BM_TAGS, S_PREDS, S_PRED, S_END };  // builder state
+enum { F_NONE, F_ACTIVE, F_TABS, F_BOOKMARKS, F_PREDICT, F_CURRENT, F_BACK, F_FORWARD,
+       F_CURRENT_TS, F_BACK_TS, F_FORWARD_TS, F_BRANCHES, F_TAB_ID, F_ID, F_AT, F_AT_TS, F_PAGES, F_PAGES_TS,
+       F_NAME, F_URL, F_FOLDER, F_TAGS, F_FROM, F_TOTAL, F_TO, F_N, F_ERR };
+
+typedef struct { int64_t *v; int n, cap; } TsList;
+
+struct SessionLoader {
+    TabManager *dst, tmp;
+    int bad;
+    // lexer
+    int lst, expect, depth, is_key, ucount;
+    char stack[LEX_DEPTH];
+    char *str; size_t slen, scap;
+    unsigned uacc, uhigh;
+    // builder
+    int state, field, read_tabs, read_active;
+    char *cur; StrPack back, fwd, *list;
+    int64_t cur_ts; TsList bts, fts, *tslist;   // visit times, matched to the lists when the tab closes
+    uint64_t tab_id;                            // 0: none in the file, the tab gets a fresh one
+    int list_state;                             // where a list or stamp array returns to
+    char *br_at; int64_t br_at_ts, br_id; StrPack br_pages; TsList brts;   // branch being read
+    int br_table;                               // ...into the root branch table, stamps absolute
+    U64Map brtab; Branch **tbl; int ntbl;       // that table: file id -> branch, and one reference to each
+    Branch **brs; int nbrs, brcap;              // this tab's branches
+    unsigned char brrel[BROWSER_BRANCHES];      // 1: read inline, stamps still relative to cur_ts
+    char *bm_name, *bm_url, *bm_folder; StrPack bm_tags;
+    char *pr_from; int64_t pr_total; StrPack pr_to; TsList pr_n, pr_err;   // predictor row being read
+    int64_t load_ms;
+};
+
+static void lex_put(SessionLoader *ld, char c) {
+    if (ld->slen + 2 > ld->scap) { ld->scap = ld->scap ? ld->scap * 2 : 256; ld->str = (char*)realloc(ld->str, ld->scap); }
+    ld->str[ld->slen++] = c; ld->str[ld->slen] = '\0';
+}
 
-        fputc('}', f);
+static void lex_put_span(SessionLoader *ld, const char *p, size_t n) {
+    if (ld->slen + n + 1 > ld->scap) {
+        while (ld->slen + n + 1 > ld->scap) ld->scap = ld->scap ? ld->scap * 2 : 256;
+        ld->str = (char*)realloc(ld->str, ld->scap);
     }
-    fprintf(f, "],\"active\":%d}\n", tm->active < 0 ? 0 : tm->active);
-    fclose(f);
+    memcpy(ld->str + ld->slen, p, n); ld->slen += n; ld->str[ld->slen] = '\0';
+}
+
+static void lex_put_utf8(SessionLoader *ld, unsigned cp) {
+    if (cp < 0x80) { lex_put(ld, (char)cp); return; }
+    if (cp < 0x800) { lex_put(ld, (char)(0xC0 | cp >> 6)); }
+    else {
+        if (cp < 0x10000) lex_put(ld, (char)(0xE0 | cp >> 12));
+        else { lex_put(ld, (char)(0xF0 | cp >> 18)); lex_put(ld, (char)(0x80 | (cp >> 12 & 0x3F))); }
+        lex_put(ld, (char)(0x80 | (cp >> 6 & 0x3F)));
+    }
+    lex_put(ld, (char)(0x80 | (cp & 0x3F)));
+}
+
+static int field_of(const char *k, int state) {
+    static const struct { int state; const char *key; int field; } keys[] = {
+        { S_ROOT, "tabs", F_TABS }, { S_ROOT, "bookmarks", F_BOOKMARKS }, { S_ROOT, "active", F_ACTIVE },
+        { S_ROOT, "predict", F_PREDICT }, { S_ROOT, "branches", F_BRANCHES },
+        { S_TAB, "current", F_CURRENT }, { S_TAB, "back", F_BACK }, { S_TAB, "forward", F_FORWARD },
+        { S_TAB, "current_ts", F_CURRENT_TS }, { S_TAB, "back_ts", F_BACK_TS }, { S_TAB, "forward_ts", F_FORWARD_TS },
+        { S_TAB, "branches", F_BRANCHES }, { S_TAB, "tab_id", F_TAB_ID },
+        { S_BRANCH, "id", F_ID }, { S_BRANCH, "at", F_AT }, { S_BRANCH, "at_ts", F_AT_TS },
+        { S_BRANCH, "pages", F_PAGES }, { S_BRANCH, "pages_ts", F_PAGES_TS },
+        { S_BM, "name", F_NAME }, { S_BM, "url", F_URL }, { S_BM, "folder", F_FOLDER }, { S_BM, "tags", F_TAGS },
+        { S_PRED, "from", F_FROM }, { S_PRED, "total", F_TOTAL }, { S_PRED, "to", F_TO },
+        { S_PRED, "n", F_N }, { S_PRED, "err", F_ERR },
+    };
+    for (size_t i = 0; i < sizeof keys / sizeof keys[0]; ++i)
+        if (keys[i].state == state && strcmp(keys[i].key, k) == 0) return keys[i].field;
+    return F_NONE;
+}
+
+static int parse_ts(const char *s, int64_t *out) {
+    char *end; long long v = strtoll(s, &end, 10);
+    if (*end || end == s) return 0;
+    *out = (int64_t)v; return 1;
+}
+
+// back_ts/forward_ts hold offsets from current_ts; they only apply when there
+// is one per entry (files from before timestamps have none)
+static void apply_ts(StrPack *p, const TsList *t, int64_t base) {
+    for (int i = 0; i < p->size; ++i) sp_set_ts(p, i, t->n == p->size ? base + t->v[i] : 0);
+}
+
+// The tab comes back uncapped; tm_adopt_tab trims back to the manager's cap,
+// spilling the overflow to the cold tier when one is configured.
+static void build_tab(SessionLoader *ld) {
+    Browser *b = (Browser*)malloc(sizeof(Browser));
+    browser_init(b, "", SP_UNBOUNDED);
+    free(b->current); b->current = ld->cur ? ld->cur : sdup("");
+    b->current_ts = ld->cur_ts;
+    if (ld->tab_id) b->tab_id = ld->tab_id;
+    ld->tab_id = 0;
+    apply_ts(&ld->back, &ld->bts, ld->cur_ts); apply_ts(&ld->fwd, &ld->fts, ld->cur_ts);
+    ld->bts.n = ld->fts.n = 0;
+    // hand the packed stacks over wholesale, no per-entry copies
+    sp_free(&b->back); b->back = ld->back;
+    sp_free(&b->fwd);  b->fwd  = ld->fwd;
+    ld->cur = NULL; sp_init(&ld->back, SP_UNBOUNDED); sp_init(&ld->fwd, SP_UNBOUNDED);
+    for (int i = 0; i < ld->nbrs; ++i) {
+        Branch *br = ld->brs[i];
+        if (!ld->brrel[i]) continue;   // from the branch table, already absolute
+        br->at_ts += ld->cur_ts; br->ts += ld->cur_ts;
+        for (int j = 0; j < br->pages.size; ++j) sp_set_ts(&br->pages, j, sp_ts(&br->pages, j) + ld->cur_ts);
+    }
+    if (ld->nbrs) { b->branches = ld->brs; b->nbranches = ld->nbrs; ld->brs = NULL; ld->nbrs = ld->brcap = 0; }
+    ld->cur_ts = 0;
+    browser_sync_clock(b);
+    tm_adopt_tab(&ld->tmp, b);
+}
+
+static void build_bookmark(SessionLoader *ld) {
+    int idx = tm_bookmark_add(&ld->tmp, ld->bm_name, ld->bm_url);
+    bm_set_folder(&ld->tmp.bookmarks, idx, ld->bm_folder);
+    for (int i = 0; i < ld->bm_tags.size; ++i) bm_tag(&ld->tmp.bookmarks, idx, sp_at(&ld->bm_tags, i));
+    free(ld->bm_name); free(ld->bm_url); free(ld->bm_folder);
+    ld->bm_name = ld->bm_url = ld->bm_folder = NULL;
+    sp_clear(&ld->bm_tags);
+}
+
+// one successor row; counts must line up, fit, and come most frequent first
+// as the predictor keeps them
+static int build_pred(SessionLoader *ld) {
+    int k = ld->pr_to.size;
+    if (!ld->pr_from || k > PRED_K || ld->pr_n.n != k || ld->pr_err.n != k) return 0;
+    if (ld->pr_total < 0 || ld->pr_total > UINT32_MAX) return 0;
+    for (int i = 0; i < k; ++i) {
+        int64_t n = ld->pr_n.v[i], e = ld->pr_err.v[i];
+        if (n < 1 || n > UINT32_MAX || e < 0 || e > n) return 0;
+        if (i && n > ld->pr_n.v[i - 1]) return 0;
+        if (strcmp(sp_at(&ld->pr_to, i), ld->pr_from) == 0) return 0;
+        for (int j = 0; j < i; ++j) if (strcmp(sp_at(&ld->pr_to, j), sp_at(&ld->pr_to, i)) == 0) return 0;
+    }
+    Predictor *pr = &ld->tmp.pred;
+    PredRow *r = pred_row(pr, ld->pr_from);
+    if (r->nnext) return 0;   // the same url twice
+    for (int i = 0; i < k; ++i) {
+        r->next[i].to = pred_row(pr, sp_at(&ld->pr_to, i));
+        r->next[i].to->refs++;
+        r->next[i].n = (uint32_t)ld->pr_n.v[i]; r->next[i].err = (uint32_t)ld->pr_err.v[i];
+    }
+    r->nnext = k; r->total = (uint32_t)ld->pr_total;
+    r->ts = ld->load_ms;   // the file keeps no update times: loaded rows are as new as the load
+    pr->version++;
     return 1;
 }
 
-/*  Minimal JSON reader  */
-
-typedef struct { const char *s; size_t i, n; } JIn;
-static void jin_init(JIn *in, const char *buf, size_t n) { in->s = buf; in->i = 0; in->n = n; }
-static void jin_skip_ws(JIn *in) { while (in->i < in->n && isspace((unsigned char)in->s[in->i])) in->i++; }
-static int  jin_expect(JIn *in, char c) { jin_skip_ws(in); if (in->i < in->n && in->s[in->i]==c) { in->i++; return 1; } return 0; }
-static char *jin_read_string(JIn *in) {
-    jin_skip_ws(in);
-    if (in->i >= in->n || in->s[in->i] != '"') return NULL;
-    in->i++;
-    char *out = NULL; size_t cap = 0, len = 0;
-    while (in->i < in->n) {
-        unsigned char c = (unsigned char)in->s[in->i++];
-        if (c == '"') break;
-        if (c == '\\') {
-            if (in->i >= in->n) break;
-            unsigned char e = (unsigned char)in->s[in->i++];
-            switch (e) {
-                case 'n': c='\n'; break; case 'r': c='\r'; break; case 't': c='\t'; break;
-                case '\\': c='\\'; break; case '"': c='"'; break;
-                case 'u': if (in->i + 4 <= in->n) in->i += 4; c='?'; break;
-                default: c=e; break;
-            }
+// schema builder: one event in, 0 when it does not fit the session layout
+static int build_event(SessionLoader *ld, int ev, const char *s) {
+    int f = ld->field;
+    if (ev == EV_KEY) {
+        if (ld->state != S_ROOT && ld->state != S_TAB && ld->state != S_BRANCH && ld->state != S_BM
+            && ld->state != S_PRED) return 0;
+        return (ld->field = field_of(s, ld->state)) != F_NONE;
+    }
+    ld->field = F_NONE;
+    switch (ld->state) {
+    case S_START:
+        if (ev != EV_BEGIN_OBJ) return 0;
+        ld->state = S_ROOT; return 1;
+    case S_ROOT:
+        if (ev == EV_END_OBJ) { ld->state = S_END; return 1; }
+        if (ev == EV_BEGIN_ARR && f == F_TABS) { ld->state = S_TABS; ld->read_tabs = 1; return 1; }
+        if (ev == EV_BEGIN_ARR && f == F_BOOKMARKS) { ld->state = S_BMS; return 1; }
+        if (ev == EV_BEGIN_ARR && f == F_PREDICT) { ld->state = S_PREDS; return 1; }
+        if (ev == EV_BEGIN_ARR && f == F_BRANCHES) { ld->state = S_BRTABLE; ld->br_table = 1; return 1; }
+        if (ev == EV_NUMBER && f == F_ACTIVE) {
+            char *end; long v = strtol(s, &end, 10);
+            if (*end || end == s) return 0;
+            ld->tmp.active = (int)v; ld->read_active = 1; return 1;
+        }
+        return 0;
+    case S_TABS:
+        if (ev == EV_BEGIN_OBJ) { ld->state = S_TAB; return 1; }
+        if (ev == EV_END_ARR) { ld->state = S_ROOT; return 1; }
+        return 0;
+    case S_TAB:
+        if (ev == EV_STRING && f == F_CURRENT) { free(ld->cur); ld->cur = sdup(s); return 1; }
+        if (ev == EV_BEGIN_ARR && (f == F_BACK || f == F_FORWARD)) {
+            ld->list = f == F_BACK ? &ld->back : &ld->fwd;
+            sp_clear(ld->list);
+            ld->list_state = S_TAB; ld->state = S_TAB_LIST; return 1;
+        }
+        if (ev == EV_NUMBER && f == F_CURRENT_TS) return parse_ts(s, &ld->cur_ts);
+        if (ev == EV_STRING && f == F_TAB_ID) {
+            char *end; unsigned long long v = strtoull(s, &end, 16);
+            if (*end || end == s || !v) return 0;
+            ld->tab_id = (uint64_t)v; return 1;
+        }
+        if (ev == EV_BEGIN_ARR && (f == F_BACK_TS || f == F_FORWARD_TS)) {
+            ld->tslist = f == F_BACK_TS ? &ld->bts : &ld->fts;
+            ld->tslist->n = 0;
+            ld->list_state = S_TAB; ld->state = S_TAB_TS; return 1;
+        }
+        if (ev == EV_BEGIN_ARR && f == F_BRANCHES) { ld->state = S_BRANCHES; return 1; }
+        if (ev == EV_END_OBJ) { build_tab(ld); ld->state = S_TABS; return 1; }
+        return 0;
+    case S_BRTABLE:
+    case S_BRANCHES:
+        if (ev == EV_BEGIN_OBJ) {
+            free(ld->br_at); ld->br_at = NULL; ld->br_at_ts = 0; ld->br_id = -1;
+            sp_clear(&ld->br_pages); ld->brts.n = 0;
+            ld->state = S_BRANCH; return 1;
+        }
+        if (ev == EV_END_ARR) { ld->state = ld->br_table ? S_ROOT : S_TAB; ld->br_table = 0; return 1; }
+        if (ev == EV_NUMBER && !ld->br_table) {   // a branch from the table, shared with the other tabs naming it
+            int64_t id; void **slot;
+            if (!parse_ts(s, &id) || id < 0 || !(slot = um_get(&ld->brtab, (uint64_t)id)) || ld->nbrs == BROWSER_BRANCHES) return 0;
+            if (!ld->brs) ld->brs = (Branch**)malloc(BROWSER_BRANCHES * sizeof(Branch*));
+            Branch *br = (Branch*)*slot;
+            br->refs++;
+            ld->brrel[ld->nbrs] = 0; ld->brs[ld->nbrs++] = br;
+            return 1;
+        }
+        return 0;
+    case S_BRANCH:
+        if (ev == EV_NUMBER && f == F_ID && ld->br_table) return parse_ts(s, &ld->br_id) && ld->br_id >= 0;
+        if (ev == EV_STRING && f == F_AT) { free(ld->br_at); ld->br_at = sdup(s); return 1; }
+        if (ev == EV_NUMBER && f == F_AT_TS) return parse_ts(s, &ld->br_at_ts);
+        if (ev == EV_BEGIN_ARR && f == F_PAGES) {
+            ld->list = &ld->br_pages; sp_clear(ld->list);
+            ld->list_state = S_BRANCH; ld->state = S_TAB_LIST; return 1;
+        }
+        if (ev == EV_BEGIN_ARR && f == F_PAGES_TS) {
+            ld->tslist = &ld->brts; ld->tslist->n = 0;
+            ld->list_state = S_BRANCH; ld->state = S_TAB_TS; return 1;
+        }
+        if (ev == EV_END_OBJ && ld->br_table) {
+            int created;
+            if (!ld->br_at || ld->br_id < 0) return 0;
+            void **slot = um_put(&ld->brtab, (uint64_t)ld->br_id, &created);
+            if (!created) return 0;   // the same id twice
+            apply_ts(&ld->br_pages, &ld->brts, ld->br_at_ts);
+            Branch *br = branch_new(ld->br_at, ld->br_at_ts, &ld->br_pages);
+            *slot = br;
+            ld->tbl = (Branch**)realloc(ld->tbl, (size_t)(ld->ntbl + 1) * sizeof(Branch*));
+            ld->tbl[ld->ntbl++] = br;
+            ld->state = S_BRTABLE; return 1;
+        }
+        if (ev == EV_END_OBJ) {
+            if (!ld->br_at || ld->nbrs == BROWSER_BRANCHES) return 0;
+            apply_ts(&ld->br_pages, &ld->brts, ld->br_at_ts);
+            if (!ld->brs) ld->brs = (Branch**)malloc(BROWSER_BRANCHES * sizeof(Branch*));
+            ld->brrel[ld->nbrs] = 1;
+            ld->brs[ld->nbrs++] = branch_new(ld->br_at, ld->br_at_ts, &ld->br_pages);
+            ld->state = S_BRANCHES; return 1;
         }
-        if (len + 1 >= cap) { cap = cap ? cap * 2 : 32; out = (char*)realloc(out, cap); }
-        out[len++] = (char)c;
+        return 0;
+    case S_TAB_LIST:
+        if (ev == EV_STRING) { sp_push(ld->list, s); return 1; }
+        if (ev == EV_END_ARR) { ld->state = ld->list_state; return 1; }
+        return 0;
+    case S_TAB_TS: {
+        if (ev == EV_END_ARR) { ld->state = ld->list_state; return 1; }
+        TsList *t = ld->tslist;
+        if (ev != EV_NUMBER) return 0;
+        if (t->n == t->cap) { t->cap = t->cap ? t->cap * 2 : 16; t->v = (int64_t*)realloc(t->v, (size_t)t->cap * sizeof(int64_t)); }
+        return parse_ts(s, &t->v[t->n++]);
     }
-    if (!out) return sdup("");
-    out[len] = '\0';
-    return out;
-}
-
-static int jin_read_string_array(JIn *in, Vec *v) {
-    v->size = 0;
-    if (!jin_expect(in, '[')) return 0;
-    jin_skip_ws(in);
-    if (jin_expect(in, ']')) return 1; // empty
-    do {
-        char *s = jin_read_string(in); if (!s) return 0;
-        vec_push(v, s);
-        jin_skip_ws(in);
-    } while (jin_expect(in, ','));
-    return jin_expect(in, ']');
-}
-
-static int jin_read_tab(JIn *in, Browser **out, int back_cap) {
-    if (!jin_expect(in, '{')) return 0;
-
-    char *cur = NULL; Vec backV; vec_init(&backV); Vec fwdV; vec_init(&fwdV);
-
-    for (;;) {
-        jin_skip_ws(in);
-        if (jin_expect(in, '}')) break;
-        char *key = jin_read_string(in); if (!key) { vec_free(&backV); vec_free(&fwdV); return 0; }
-        if (!jin_expect(in, ':')) { free(key); vec_free(&backV); vec_free(&fwdV); return 0; }
-        if (strcmp(key, "current") == 0) {
-            free(cur); cur = jin_read_string(in); if (!cur) { free(key); vec_free(&backV); vec_free(&fwdV); return 0; }
-        } else if (strcmp(key, "back") == 0) {
-            vec_clear_free(&backV);
-            if (!jin_read_string_array(in, &backV)) { free(key); free(cur); vec_free(&backV); vec_free(&fwdV); return 0; }
-        } else if (strcmp(key, "forward") == 0) {
-            vec_clear_free(&fwdV);
-            if (!jin_read_string_array(in, &fwdV)) { free(key); free(cur); vec_free(&backV); vec_free(&fwdV); return 0; }
-        } else { free(key); free(cur); vec_free(&backV); vec_free(&fwdV); return 0; }
-        free(key);
-        jin_skip_ws(in); if (jin_expect(in, ',')) continue; if (jin_expect(in, '}')) break;
+    case S_BMS:
+        if (ev == EV_BEGIN_OBJ) { ld->state = S_BM; return 1; }
+        if (ev == EV_END_ARR) { ld->state = S_ROOT; return 1; }
+        return 0;
+    case S_BM:
+        if (ev == EV_STRING && (f == F_NAME || f == F_URL || f == F_FOLDER)) {
+            char **dst = f == F_NAME ? &ld->bm_name : f == F_URL ? &ld->bm_url : &ld->bm_folder;
+            free(*dst); *dst = sdup(s); return 1;
+        }
+        if (ev == EV_BEGIN_ARR && f == F_TAGS) { sp_clear(&ld->bm_tags); ld->state = S_BM_TAGS; return 1; }
+        if (ev == EV_END_OBJ) {
+            if (!ld->bm_name || !ld->bm_url) return 0;
+            build_bookmark(ld); ld->state = S_BMS; return 1;
+        }
+        return 0;
+    case S_BM_TAGS:
+        if (ev == EV_STRING) { sp_push(&ld->bm_tags, s); return 1; }
+        if (ev == EV_END_ARR) { ld->state = S_BM; return 1; }
+        return 0;
+    case S_PREDS:
+        if (ev == EV_BEGIN_OBJ) {
+            free(ld->pr_from); ld->pr_from = NULL; ld->pr_total = 0;
+            sp_clear(&ld->pr_to); ld->pr_n.n = ld->pr_err.n = 0;
+            ld->state = S_PRED; return 1;
+        }
+        if (ev == EV_END_ARR) { ld->state = S_ROOT; return 1; }
+        return 0;
+    case S_PRED:
+        if (ev == EV_STRING && f == F_FROM) { free(ld->pr_from); ld->pr_from = sdup(s); return 1; }
+        if (ev == EV_NUMBER && f == F_TOTAL) return parse_ts(s, &ld->pr_total);
+        if (ev == EV_BEGIN_ARR && f == F_TO) {
+            ld->list = &ld->pr_to; sp_clear(ld->list);
+            ld->list_state = S_PRED; ld->state = S_TAB_LIST; return 1;
+        }
+        if (ev == EV_BEGIN_ARR && (f == F_N || f == F_ERR)) {
+            ld->tslist = f == F_N ? &ld->pr_n : &ld->pr_err; ld->tslist->n = 0;
+            ld->list_state = S_PRED; ld->state = S_TAB_TS; return 1;
+        }
+        if (ev == EV_END_OBJ) {
+            if (!build_pred(ld)) return 0;
+            ld->state = S_PREDS; return 1;
+        }
+        return 0;
+    default:
+        return 0;
     }
+}
 
-    Browser *b = (Browser*)malloc(sizeof(Browser));
-    browser_init(b, cur ? cur : "", back_cap);
+static void lex_after_value(SessionLoader *ld) { ld->expect = ld->depth ? X_NEXT : X_DONE; }
 
-    for (int i = 0; i < backV.size; ++i) ring_push_back(&b->back, backV.data[i]);
-    backV.size = 0; vec_free(&backV);
+static int lex_emit(SessionLoader *ld, int ev) {
+    if (!build_event(ld, ev, ld->str ? ld->str : "")) ld->bad = 1;
+    return !ld->bad;
+}
 
-    free(b->current); b->current = cur ? cur : sdup("");
+// one structural byte (or the start of a string/number) while between tokens
+static int lex_ws(SessionLoader *ld, char c) {
+    int x = ld->expect;
+    int want_value = x == X_VALUE || x == X_VALUE_OR_END;
+    switch (c) {
+    case ' ': case '\t': case '\r': case '\n':
+        return 1;
+    case '{': case '[':
+        if (!want_value || ld->depth == LEX_DEPTH) return 0;
+        ld->stack[ld->depth++] = c;
+        ld->expect = c == '{' ? X_KEY_OR_END : X_VALUE_OR_END;
+        return lex_emit(ld, c == '{' ? EV_BEGIN_OBJ : EV_BEGIN_ARR);
+    case '}': case ']': {
+        char open = c == '}' ? '{' : '[';
+        if (!ld->depth || ld->stack[ld->depth - 1] != open) return 0;
+        if (x != X_NEXT && x != (c == '}' ? X_KEY_OR_END : X_VALUE_OR_END)) return 0;
+        ld->depth--;
+        lex_after_value(ld);
+        return lex_emit(ld, c == '}' ? EV_END_OBJ : EV_END_ARR);
+    }
+    case ',':
+        if (x != X_NEXT) return 0;
+        ld->expect = ld->stack[ld->depth - 1] == '{' ? X_KEY : X_VALUE;
+        return 1;
+    case ':':
+        if (x != X_COLON) return 0;
+        ld->expect = X_VALUE;
+        return 1;
+    case '"':
+        if (x == X_KEY || x == X_KEY_OR_END) ld->is_key = 1;
+        else if (want_value) ld->is_key = 0;
+        else return 0;
+        ld->lst = L_STR; ld->slen = 0; lex_put_span(ld, "", 0);   // "" must not see the last string
+        return 1;
+    default:
+        if (!want_value || !(isalnum((unsigned char)c) || c == '-')) return 0;
+        ld->lst = L_NUM; ld->slen = 0; lex_put(ld, c);
+        return 1;
+    }
+}
 
-    for (int i = 0; i < fwdV.size; ++i) vec_push(&b->fwd, fwdV.data[i]);
-    fwdV.size = 0; vec_free(&fwdV);
+static int lex_end_number(SessionLoader *ld) {
+    ld->lst = L_WS;
+    lex_after_value(ld);
+    return lex_emit(ld, EV_NUMBER);
+}
 
-    *out = b; return 1;
+SessionLoader *session_loader_open(TabManager *tm, int back_cap_default) {
+    SessionLoader *ld = (SessionLoader*)calloc(1, sizeof(SessionLoader));
+    ld->dst = tm;
+    tm_init(&ld->tmp, back_cap_default);
+    tm_set_spill_dir(&ld->tmp, tm->spill_dir); ld->tmp.spill_seq = tm->spill_seq; ld->tmp.spill_inst = tm->spill_inst;
+    ld->tmp.unindexed = tm->unindexed; ld->tmp.view = tm->view;
+    ld->tmp.next_uid = tm->next_uid;   // loaded tabs get fresh uids; the shared view tells tabs apart by them
+    // the budget and what it has evicted so far carry over to the loaded session
+    ld->tmp.mem.limit = tm->mem.limit;
+    ld->tmp.mem.evicted = tm->mem.evicted; ld->tmp.mem.spilled = tm->mem.spilled;
+    ld->tmp.mem.undo_dropped = tm->mem.undo_dropped; ld->tmp.mem.pred_dropped = tm->mem.pred_dropped;
+    ld->tmp.mem.passes = tm->mem.passes;
+    sp_init(&ld->back, SP_UNBOUNDED); sp_init(&ld->fwd, SP_UNBOUNDED); sp_init(&ld->bm_tags, SP_UNBOUNDED);
+    sp_init(&ld->br_pages, SP_UNBOUNDED); sp_init(&ld->pr_to, SP_UNBOUNDED);
+    um_init(&ld->brtab);
+    ld->load_ms = wall_ms();
+    ld->lst = L_WS; ld->expect = X_VALUE; ld->state = S_START;
+    return ld;
 }
 
-int load_session_json(const char *path, TabManager *tm, int back_cap_default) {
-    FILE *f = fopen(path, "rb"); if (!f) return 0;
-    fseek(f, 0, SEEK_END); long n = ftell(f); fseek(f, 0, SEEK_SET);
-    if (n <= 0) { fclose(f); return 0; }
-    char *buf = (char*)malloc((size_t)n + 1); if (!buf) { fclose(f); return 0; }
-    fread(buf, 1, (size_t)n, f); buf[n] = '\0'; fclose(f);
+int session_loader_feed(SessionLoader *ld, const void *data, size_t n) {
+    const char *p = (const char*)data;
+    for (size_t i = 0; i < n && !ld->bad; ++i) {
+        char c = p[i];
+        switch (ld->lst) {
+        case L_STR: {   // copy the run up to the next quote or escape in one go
+            size_t j = i;
+            while (j < n && p[j] != '"' && p[j] != '\\') j++;
+            lex_put_span(ld, p + i, j - i);
+            i = j;
+            if (j == n) break;
+            if (p[j] == '\\') { ld->lst = L_ESC; break; }
+            ld->lst = L_WS;
+            if (ld->is_key) { ld->expect = X_COLON; lex_emit(ld, EV_KEY); }
+            else { lex_after_value(ld); lex_emit(ld, EV_STRING); }
+            break;
+        }
+        case L_ESC:
+            ld->lst = L_STR;
+            switch (c) {
+                case 'n': lex_put(ld, '\n'); break; case 'r': lex_put(ld, '\r'); break;
+                case 't': lex_put(ld, '\t'); break; case 'b': lex_put(ld, '\b'); break;
+                case 'f': lex_put(ld, '\f'); break;
+                case 'u': ld->lst = L_UESC; ld->ucount = 0; ld->uacc = 0; break;
+                default:  lex_put(ld, c); break;
+            }
+            break;
+        case L_UESC:
+            if (!isxdigit((unsigned char)c)) { ld->bad = 1; break; }
+            ld->uacc = ld->uacc * 16 + (unsigned)(isdigit((unsigned char)c) ? c - '0' : tolower((unsigned char)c) - 'a' + 10);
+            if (++ld->ucount < 4) break;
+            ld->lst = L_STR;
+            if (ld->uacc >= 0xD800 && ld->uacc < 0xDC00) { ld->uhigh = ld->uacc; break; }
+            if (ld->uacc >= 0xDC00 && ld->uacc < 0xE000 && ld->uhigh)
+                lex_put_utf8(ld, 0x10000 + ((ld->uhigh - 0xD800) << 10) + (ld->uacc - 0xDC00));
+            else lex_put_utf8(ld, ld->uacc);
+            ld->uhigh = 0;
+            break;
+        case L_NUM:
+            if (isalnum((unsigned char)c) || c == '-' || c == '+' || c == '.') { lex_put(ld, c); break; }
+            if (!lex_end_number(ld)) break;
+            /* fall through */
+        default:
+            if (ld->lst == L_WS && ld->expect != X_DONE && !lex_ws(ld, c)) ld->bad = 1;   // bytes after the document are ignored
+            break;
+        }
+    }
+    return !ld->bad;
+}
 
-    JIn in; jin_init(&in, buf, (size_t)n);
-    if (!jin_expect(&in, '{')) { free(buf); return 0; }
+int session_loader_close(SessionLoader *ld, int commit) {
+    if (!ld->bad && ld->lst == L_NUM) lex_end_number(ld);
+    int ok = commit && !ld->bad && ld->expect == X_DONE && ld->state == S_END && ld->read_tabs;
+    TabManager *tmp = &ld->tmp;
+    free(ld->str); free(ld->cur); free(ld->bm_name); free(ld->bm_url); free(ld->bm_folder);
+    sp_free(&ld->back); sp_free(&ld->fwd); sp_free(&ld->bm_tags);
+    free(ld->bts.v); free(ld->fts.v);
+    free(ld->br_at); sp_free(&ld->br_pages); free(ld->brts.v);
+    free(ld->pr_from); sp_free(&ld->pr_to); free(ld->pr_n.v); free(ld->pr_err.v);
+    for (int i = 0; i < ld->nbrs; ++i) branch_release(ld->brs[i]);   // tab never finished
+    free(ld->brs);
+    for (int i = 0; i < ld->ntbl; ++i) branch_release(ld->tbl[i]);   // the tabs hold their own references
+    free(ld->tbl); um_free(&ld->brtab);
+    if (!ok) { tm_destroy(tmp); free(ld); return 0; }
+    if (!ld->read_active || tmp->active < 0 || tmp->active >= tmp->count) tmp->active = (tmp->count ? 0 : -1);
+    TabManager *tm = ld->dst;
+    tm_destroy(tm); *tm = *tmp; tm_rebind(tm);
+    free(ld);
+    return 1;
+}
 
-    TabManager tmp; tm_init(&tmp, back_cap_default);
-    int read_tabs = 0, read_active = 0;
-
-    for (;;) {
-        jin_skip_ws(&in);
-        if (jin_expect(&in, '}')) break;
-        char *key = jin_read_string(&in); if (!key) { free(buf); tm_destroy(&tmp); return 0; }
-        if (!jin_expect(&in, ':')) { free(key); free(buf); tm_destroy(&tmp); return 0; }
-        if (strcmp(key, "tabs") == 0) {
-            if (!jin_expect(&in, '[')) { free(key); free(buf); tm_destroy(&tmp); return 0; }
-            jin_skip_ws(&in);
-            if (!jin_expect(&in, ']')) {
-                do {
-                    Browser *b = NULL; if (!jin_read_tab(&in, &b, back_cap_default)) { free(key); free(buf); tm_destroy(&tmp); return 0; }
-                    // append
-                    // reserve
-                    if (tmp.cap <= tmp.count) {
-                        int c = tmp.cap ? tmp.cap : 4; while (c <= tmp.count) c <<= 1;
-                        tmp.tabs = (Browser**)realloc(tmp.tabs, (size_t)c * sizeof(Browser*)); tmp.cap = c;
-                    }
-                    tmp.tabs[tmp.count++] = b;
-                    jin_skip_ws(&in);
-                } while (jin_expect(&in, ','));
-                if (!jin_expect(&in, ']')) { free(key); free(buf); tm_destroy(&tmp); return 0; }
-            }
-            read_tabs = 1;
-        } else if (strcmp(key, "active") == 0) {
-            jin_skip_ws(&in);
-            int sign = 1; if (in.s[in.i]=='-') { sign=-1; in.i++; }
-            int val = 0, any = 0; while (in.i < in.n && isdigit((unsigned char)in.s[in.i])) { val = val*10 + (in.s[in.i]-'0'); in.i++; any=1; }
-            if (!any) { free(key); free(buf); tm_destroy(&tmp); return 0; }
-            tmp.active = sign*val; read_active = 1;
-        } else { free(key); free(buf); tm_destroy(&tmp); return 0; }
-        free(key);
-        jin_skip_ws(&in); if (jin_expect(&in, ',')) continue; if (jin_expect(&in, '}')) break;
+/* A file in the LZ container is recognised by its first four bytes, read
+   on their own so nothing has to be put back: pipes work the same as files. */
+int load_session_file(FILE *f, TabManager *tm, int back_cap_default) {
+    SessionLoader *ld = session_loader_open(tm, back_cap_default);
+    char *chunk = (char*)malloc(LOAD_CHUNK);
+    size_t got = fread(chunk, 1, LZ_MAGIC_LEN, f);
+    int ok = 1;
+    if (got == LZ_MAGIC_LEN && memcmp(chunk, LZ_MAGIC, LZ_MAGIC_LEN) == 0) {
+        LzReader *r = lzr_open(f);
+        if (!r) ok = 0;
+        else {
+            while (ok && (got = lzr_read(r, chunk, LOAD_CHUNK)) > 0) ok = session_loader_feed(ld, chunk, got);
+            if (lzr_error(r)) ok = 0;
+            lzr_close(r);
+        }
+    } else {
+        ok = session_loader_feed(ld, chunk, got);
+        while (ok && (got = fread(chunk, 1, LOAD_CHUNK, f)) > 0) ok = session_loader_feed(ld, chunk, got);
+        if (ferror(f)) ok = 0;
     }
-    free(buf);
+    free(chunk);
+    return session_loader_close(ld, ok);
+}
 
-    if (!read_tabs) { tm_destroy(&tmp); return 0; }
-    if (!read_active || tmp.active < 0 || tmp.active >= tmp.count) tmp.active = (tmp.count ? 0 : -1);
+int load_session_fd(int fd, TabManager *tm, int back_cap_default) {
+#if defined(_WIN32) || defined(_WIN64)
+    FILE *f = _fdopen(_dup(fd), "rb");
+#else
+    FILE *f = fdopen(dup(fd), "rb");
+#endif
+    if (!f) return 0;
+    int ok = load_session_file(f, tm, back_cap_default);
+    fclose(f);
+    return ok;
+}
 
-    tm_destroy(tm); *tm = tmp; return 1;
+int load_session_json(const char *path, TabManager *tm, int back_cap_default) {
+    TRACE_BEGIN(span, "load_session_json");
+    int ok = 0;
+    if (strcmp(path, "-") == 0) ok = load_session_file(stdin, tm, back_cap_default);
+    else {
+        FILE *f = fopen(path, "rb");
+        if (f) { ok = load_session_file(f, tm, back_cap_default); fclose(f); }
+    }
+    TRACE_END_ARG(span, path);
+    return ok;
 }
 
 char *session_serialize_tab_json(const Browser *b){
+    return serialize_tab(b, NULL, 1);
+}
+
+// In a session file a tab names its branches by id (see write_session); on
+// its own (undo) it carries them inline, stamps relative to current_ts.
+static char *serialize_tab(const Browser *b, size_t *plen, int inline_branches){
     // write to a growing memory buffer
     size_t cap = 1024, len = 0;
     char *buf = (char*)malloc(cap);
@@ -209,19 +681,106 @@ char *session_serialize_tab_json(const Browser *b){
         memcpy(buf+len, tmp, (size_t)n); len+=n; buf[len]='\0'; \
     }while(0)
 
+    // back timestamps are gathered on the single pass over the cold tier
+    int64_t *bts = (int64_t*)malloc((size_t)(browser_back_total(b) + b->fwd.size + 1) * sizeof(int64_t));
     EMIT("{\"current\":"); json_escape_str_mem(&buf,&len,&cap,b->current);
     EMIT(",\"back\":[");
+    int k=0, got;
+    StrPack page; sp_init(&page, SP_UNBOUNDED);
+    for (int from=0; (got=cold_page(b,from,&page))>0; from+=got){
+        for (int j=0;j<page.size;++j){
+            if (k) EMIT(",");
+            bts[k++] = sp_ts(&page,j);
+            json_escape_str_mem(&buf,&len,&cap, sp_at(&page,j));
+        }
+    }
+    sp_free(&page);
     for (int j=0;j<b->back.size;++j){
-        if (j) EMIT(",");
-        json_escape_str_mem(&buf,&len,&cap, ring_at(&b->back,j));
+        if (k) EMIT(",");
+        bts[k++] = sp_ts(&b->back,j);
+        json_escape_str_mem(&buf,&len,&cap, sp_at(&b->back,j));
     }
     EMIT("],\"forward\":[");
     for (int j=0;j<b->fwd.size;++j){
         if (j) EMIT(",");
-        json_escape_str_mem(&buf,&len,&cap, b->fwd.data[j]);
+        json_escape_str_mem(&buf,&len,&cap, sp_at(&b->fwd,j));
     }
-    EMIT("]}");
+    for (int j=0;j<b->fwd.size;++j) bts[k+j] = sp_ts(&b->fwd,j);
+    EMIT("],\"current_ts\":%lld,\"back_ts\":", (long long)b->current_ts);
+    json_ts_list_mem(&buf,&len,&cap, bts, k, b->current_ts);
+    EMIT(",\"forward_ts\":");
+    json_ts_list_mem(&buf,&len,&cap, bts+k, b->fwd.size, b->current_ts);
+    EMIT(",\"tab_id\":\"%016llx\"", (unsigned long long)b->tab_id);
+    for (int i=0;i<b->nbranches;++i){
+        EMIT(i ? "," : ",\"branches\":[");
+        if (inline_branches) json_branch_mem(&buf,&len,&cap, b->branches[i], 0, b->current_ts);
+        else EMIT("%u", b->branches[i]->id);
+    }
+    EMIT(b->nbranches ? "]}" : "}");
     #undef EMIT
+    free(bts);
+    if (plen) *plen = len;
+    return buf;
+}
+
+static char *serialize_bookmarks(const BMList *bm, size_t *plen){
+    size_t cap = 1024, len = 0;
+    char *buf = (char*)malloc(cap);
+    #define PUTS(S) do{ size_t n_ = strlen(S); \
+        if (len + n_ + 1 > cap){ while(len+n_+1>cap) cap<<=1; buf=(char*)realloc(buf,cap);} \
+        memcpy(buf+len, S, n_ + 1); len += n_; \
+    }while(0)
+    PUTS("[");
+    for (int i=0;i<bm->size;++i){
+        const BMItem *it = &bm->data[i];
+        PUTS(i ? ",{\"name\":" : "{\"name\":"); json_escape_str_mem(&buf,&len,&cap,it->name);
+        PUTS(",\"url\":"); json_escape_str_mem(&buf,&len,&cap,it->url);
+        if (it->folder){ PUTS(",\"folder\":"); json_escape_str_mem(&buf,&len,&cap,it->folder); }
+        if (it->ntags){
+            PUTS(",\"tags\":[");
+            for (int t=0;t<it->ntags;++t){ if (t) PUTS(","); json_escape_str_mem(&buf,&len,&cap,it->tags[t]); }
+            PUTS("]");
+        }
+        PUTS("}");
+    }
+    PUTS("]");
+    #undef PUTS
+    *plen = len;
+    return buf;
+}
+
+// rows with successors only; a url that was only ever a target is recreated
+// by the rows that point at it
+static char *serialize_predictor(const Predictor *pr, size_t *plen){
+    size_t cap = 1024, len = 0;
+    char *buf = (char*)malloc(cap);
+    #define PUTS(S) do{ size_t n_ = strlen(S); \
+        if (len + n_ + 1 > cap){ while(len+n_+1>cap) cap<<=1; buf=(char*)realloc(buf,cap);} \
+        memcpy(buf+len, S, n_ + 1); len += n_; \
+    }while(0)
+    PUTS("[");
+    int first = 1;
+    for (int i=0;i<pr->rows.cap;++i){
+        if (!sm_live(&pr->rows.slots[i])) continue;
+        const PredRow *r = (const PredRow*)pr->rows.slots[i].val;
+        if (!r->nnext) continue;
+        int64_t n[PRED_K], e[PRED_K];
+        char num[48];
+        PUTS(first ? "{\"from\":" : ",{\"from\":"); first = 0;
+        json_escape_str_mem(&buf,&len,&cap,r->url);
+        snprintf(num, sizeof num, ",\"total\":%u,\"to\":[", (unsigned)r->total); PUTS(num);
+        for (int j=0;j<r->nnext;++j){
+            if (j) PUTS(",");
+            json_escape_str_mem(&buf,&len,&cap,r->next[j].to->url);
+            n[j] = r->next[j].n; e[j] = r->next[j].err;
+        }
+        PUTS("],\"n\":"); json_ts_list_mem(&buf,&len,&cap,n,r->nnext,0);
+        PUTS(",\"err\":"); json_ts_list_mem(&buf,&len,&cap,e,r->nnext,0);
+        PUTS("}");
+    }
+    PUTS("]");
+    #undef PUTS
+    *plen = len;
     return buf;
 }
 
@@ -247,30 +806,65 @@ void json_escape_str_mem(char **pbuf, size_t *plen, size_t *pcap, const char *s)
     #undef ENS
 }
 
-int session_deserialize_tab_json(const char *obj_json, Browser **out, int back_cap_default){
-    // Wrap in a tiny session to reuse existing jin_read_tab() machinery
-    size_t L = strlen(obj_json);
-    char *doc = (char*)malloc(L + 32);
-    sprintf(doc, "{ \"tabs\":[%s],\"active\":0 }", obj_json);
+// An abandoned forward stack: the page it leads on from, at_ts relative to
+// at_base, then its pages with stamps relative to that page's.
+static void json_branch_mem(char **pbuf, size_t *plen, size_t *pcap, const Branch *br, int with_id, int64_t at_base){
+    #define PUTS(S) do{ size_t n_ = strlen(S); \
+        if (*plen + n_ + 1 > *pcap){ while(*plen+n_+1>*pcap) *pcap<<=1; *pbuf=(char*)realloc(*pbuf,*pcap);} \
+        memcpy(*pbuf+*plen, S, n_ + 1); *plen += n_; \
+    }while(0)
+    char num[64];
+    if (with_id){ snprintf(num, sizeof num, "{\"id\":%u,\"at\":", br->id); PUTS(num); }
+    else PUTS("{\"at\":");
+    json_escape_str_mem(pbuf,plen,pcap,br->at);
+    snprintf(num, sizeof num, ",\"at_ts\":%lld,\"pages\":[", (long long)(br->at_ts - at_base)); PUTS(num);
+    int64_t *ts = (int64_t*)malloc((size_t)(br->pages.size + 1) * sizeof(int64_t));
+    for (int j=0;j<br->pages.size;++j){
+        if (j) PUTS(",");
+        json_escape_str_mem(pbuf,plen,pcap, sp_at(&br->pages,j));
+        ts[j] = sp_ts(&br->pages,j);
+    }
+    PUTS("],\"pages_ts\":");
+    json_ts_list_mem(pbuf,plen,pcap, ts, br->pages.size, br->at_ts);
+    PUTS("}");
+    #undef PUTS
+    free(ts);
+}
+
+// [d,d,...] with each stamp written as its offset from base, which keeps the
+// numbers short; no printf per number
+static void json_ts_list_mem(char **pbuf, size_t *plen, size_t *pcap, const int64_t *v, int n, int64_t base){
+    size_t need = *plen + (size_t)n * 21 + 3;
+    if (need > *pcap){ while (need > *pcap) *pcap <<= 1; *pbuf = (char*)realloc(*pbuf, *pcap); }
+    char *o = *pbuf + *plen;
+    *o++ = '[';
+    for (int i = 0; i < n; ++i){
+        if (i) *o++ = ',';
+        int64_t off = v[i] - base;
+        uint64_t x = off < 0 ? (*o++ = '-', 0 - (uint64_t)off) : (uint64_t)off;
+        char d[20]; int nd = 0;
+        do { d[nd++] = (char)('0' + x % 10); x /= 10; } while (x);
+        while (nd) *o++ = d[--nd];
+    }
+    *o++ = ']'; *o = '\0';
+    *plen = (size_t)(o - *pbuf);
+}
 
+int session_deserialize_tab_json(const char *obj_json, Browser **out, int back_cap_default){
+    // feed the object to the loader wrapped as a one-tab session
     TabManager tmp; tm_init(&tmp, back_cap_default);
-    int ok = 0;
-    // reuse load_session_json on memory: if your loader only supports files,
-    // write to a temp file, then load. If it supports buffer, call directly.
-    // Here, for simplicity, temp file approach:
-    char path[] = ".__reopen_tmp.json";
-    FILE *f = fopen(path,"wb"); if (!f){ free(doc); tm_destroy(&tmp); return 0; }
-    fwrite(doc,1,strlen(doc),f); fclose(f);
-    ok = load_session_json(path, &tmp, back_cap_default);
-    remove(path);
-    free(doc);
-
-    if (!ok || tmp.count == 0){ tm_destroy(&tmp); return 0; }
+    tmp.unindexed = 1;   // thrown away once the tab is out; the adopting manager indexes it
+    SessionLoader *ld = session_loader_open(&tmp, back_cap_default);
+    int ok = session_loader_feed(ld, "{\"tabs\":[", 9)
+          && session_loader_feed(ld, obj_json, strlen(obj_json))
+          && session_loader_feed(ld, "]}", 2);
+    if (!session_loader_close(ld, ok) || tmp.count == 0){ tm_destroy(&tmp); return 0; }
     *out = tmp.tabs[0];
+    (*out)->hook = NULL; (*out)->hook_ctx = NULL;   // unhooked until adopted
     // move ownership of first tab out; clean the rest of tmp
     for (int i=1;i<tmp.count;++i){ browser_destroy(tmp.tabs[i]); free(tmp.tabs[i]); }
     free(tmp.tabs);
     tmp.tabs=NULL; tmp.count=0; tmp.cap=0;
     tm_destroy(&tmp);
     return 1;
-}
\ No newline at end of file
+}
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "shmview.h"
+
+#define READ_TRIES 1000   // torn copies before shmview_read gives up
+
+#if defined(_WIN32) || defined(_WIN64)
+
+// No POSIX shared memory: the view is simply unavailable.
+ShmView     *shmview_create(const char *name) { (void)name; return NULL; }
+ShmViewData *shmview_begin(ShmView *v) { (void)v; return NULL; }
+void         shmview_end(ShmView *v) { (void)v; }
+void         shmview_destroy(ShmView *v) { (void)v; }
+ShmViewReader *shmview_attach(const char *name) { (void)name; return NULL; }
+int  shmview_read(ShmViewReader *r, ShmViewData *out) { (void)r; (void)out; return 0; }
+void shmview_detach(ShmViewReader *r) { (void)r; }
+
+#else
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct ShmView { ShmViewSeg *seg; char name[256]; };
+struct ShmViewReader { const ShmViewSeg *seg; };
+
+// shm_open wants a leading slash
+static void seg_name(const char *name, char *out, size_t cap) {
+    snprintf(out, cap, "%s%s", name[0] == '/' ? "" : "/", name);
+}
+
+ShmView *shmview_create(const char *name) {
+    ShmView *v = (ShmView*)calloc(1, sizeof(ShmView));
+    if (!v) return NULL;
+    seg_name(name, v->name, sizeof v->name);
+    // a segment left by a browser that crashed is replaced, not reused:
+    // readers still mapping it keep the old copy, which says live to the end
+    shm_unlink(v->name);
+    int fd = shm_open(v->name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) { free(v); return NULL; }
+    void *p = MAP_FAILED;
+    if (ftruncate(fd, sizeof(ShmViewSeg)) == 0)
+        p = mmap(NULL, sizeof(ShmViewSeg), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) { shm_unlink(v->name); free(v); return NULL; }
+    v->seg = (ShmViewSeg*)p;   // zero-filled by ftruncate; seq 0 with live 0 until the first update
+    v->seg->size = (uint32_t)sizeof(ShmViewSeg);
+    v->seg->data.pid = (int32_t)getpid();
+    atomic_thread_fence(memory_order_release);
+    v->seg->magic = SHMV_MAGIC;
+    return v;
+}
+
+ShmViewData *shmview_begin(ShmView *v) {
+    uint64_t s = atomic_load_explicit(&v->seg->seq, memory_order_relaxed);
+    atomic_store_explicit(&v->seg->seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);   // odd is visible before any data changes
+    return &v->seg->data;
+}
+
+void shmview_end(ShmView *v) {
+    uint64_t s = atomic_load_explicit(&v->seg->seq, memory_order_relaxed);
+    atomic_store_explicit(&v->seg->seq, s + 1, memory_order_release);
+}
+
+void shmview_destroy(ShmView *v) {
+    if (!v) return;
+    shmview_begin(v)->live = 0;
+    shmview_end(v);
+    munmap(v->seg, sizeof(ShmViewSeg));
+    shm_unlink(v->name);
+    free(v);
+}
+
+ShmViewReader *shmview_attach(const char *name) {
+    char path[256]; seg_name(name, path, sizeof path);
+    int fd = shm_open(path, O_RDONLY, 0);
+    if (fd < 0) return NULL;
+    struct stat st;
+    void *p = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size == (off_t)sizeof(ShmViewSeg))
+        p = mmap(NULL, sizeof(ShmViewSeg), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return NULL;
+    const ShmViewSeg *seg = (const ShmViewSeg*)p;
+    if (seg->magic != SHMV_MAGIC || seg->size != sizeof(ShmViewSeg)) { munmap(p, sizeof(ShmViewSeg)); return NULL; }
+    ShmViewReader *r = (ShmViewReader*)malloc(sizeof(ShmViewReader));
+    if (!r) { munmap(p, sizeof(ShmViewSeg)); return NULL; }
+    r->seg = seg;
+    return r;
+}
+
+// Copies the fixed part, then only the slots of open tabs. The copy may race
+// an update; the sequence check throws such a copy away, so the count it was
+// sized by is clamped rather than trusted.
+int shmview_read(ShmViewReader *r, ShmViewData *out) {
+    ShmViewSeg *seg = (ShmViewSeg*)r->seg;   // only the atomic load needs it writable-typed
+    for (int i = 0; i < READ_TRIES; ++i) {
+        uint64_t s1 = atomic_load_explicit(&seg->seq, memory_order_acquire);
+        if (s1 & 1) { sched_yield(); continue; }
+        memcpy(out, &seg->data, offsetof(ShmViewData, tab));
+        int n = out->count < 0 ? 0 : out->count > SHMV_TABS ? SHMV_TABS : out->count;
+        memcpy(out->tab, seg->data.tab, (size_t)n * sizeof(ShmViewTab));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&seg->seq, memory_order_relaxed) == s1) {
+            for (int t = 0; t < n; ++t) out->tab[t].url[SHMV_URL - 1] = '\0';
+            return 1;
+        }
+        sched_yield();
+    }
+    return 0;
+}
+
+void shmview_detach(ShmViewReader *r) {
+    if (!r) return;
+    munmap((void*)r->seg, sizeof(ShmViewSeg));
+    free(r);
+}
+
+#endif
@@ -0,0 +1,135 @@
+#include <stdlib.h>
+#include <string.h>
+#include "strpack.h"
+
+
+void sp_init(StrPack *s, int cap) {
+s->bytes = NULL; s->used = 0; s->bcap = 0; s->dead = 0;
+s->slot = NULL; s->first = 0; s->size = 0; s->scap = 0;
+s->cap = cap;
+}
+
+
+void sp_clear(StrPack *s) {
+s->used = 0; s->dead = 0;
+s->first = 0; s->size = 0;
+}
+
+
+void sp_free(StrPack *s) {
+free(s->bytes); free(s->slot);
+sp_init(s, s->cap);
+}
+
+
+void sp_copy(StrPack *dst, const StrPack *src) {
+sp_free(dst);
+dst->cap = src->cap;
+if (src->size == 0) return;
+size_t live = src->used - src->dead;
+dst->bytes = (char*)malloc(live);
+memcpy(dst->bytes, src->bytes + src->dead, live);
+dst->used = dst->bcap = live;
+dst->slot = (SPSlot*)malloc((size_t)src->size * sizeof(SPSlot));
+memcpy(dst->slot, src->slot + src->first, (size_t)src->size * sizeof(SPSlot));
+for (int i = 0; i < src->size; ++i) dst->slot[i].off -= src->dead;
+dst->size = dst->scap = src->size;
+}
+
+
+// slide live slots/bytes to the front once the evicted prefix dominates
+static void sp_compact(StrPack *s) {
+if (s->first > 0 && s->first >= s->size) {
+memmove(s->slot, s->slot + s->first, (size_t)s->size * sizeof(SPSlot));
+s->first = 0;
+}
+if (s->dead > 0 && s->dead >= s->used - s->dead) {
+memmove(s->bytes, s->bytes + s->dead, s->used - s->dead);
+for (int i = 0; i < s->size; ++i) s->slot[s->first + i].off -= s->dead;
+s->used -= s->dead;
+s->dead = 0;
+}
+}
+
+
+void sp_drop_front(StrPack *s) {
+if (s->size == 0) return;
+SPSlot *o = &s->slot[s->first];
+s->dead = o->off + o->len + 1;
+s->first++;
+s->size--;
+if (s->size == 0) { sp_clear(s); return; }
+sp_compact(s);
+}
+
+
+void sp_push(StrPack *s, const char *str) { sp_push_ts(s, str, 0); }
+
+
+void sp_push_ts(StrPack *s, const char *str, int64_t ts) {
+if (s->cap == 0) return;
+if (s->cap > 0 && s->size == s->cap) sp_drop_front(s);
+size_t n = strlen(str);
+if (s->used + n + 1 > s->bcap) {
+size_t c = s->bcap ? s->bcap : 256;
+while (c < s->used + n + 1) c <<= 1;
+s->bytes = (char*)realloc(s->bytes, c);
+s->bcap = c;
+}
+if (s->first + s->size + 1 > s->scap) {
+int c = s->scap ? s->scap : 8;
+while (c < s->first + s->size + 1) c <<= 1;
+s->slot = (SPSlot*)realloc(s->slot, (size_t)c * sizeof(SPSlot));
+s->scap = c;
+}
+memcpy(s->bytes + s->used, str, n + 1);
+s->slot[s->first + s->size].off = s->used;
+s->slot[s->first + s->size].len = n;
+s->slot[s->first + s->size].ts = ts;
+s->used += n + 1;
+s->size++;
+}
+
+
+char *sp_pop(StrPack *s) { return sp_pop_ts(s, NULL); }
+
+
+char *sp_pop_ts(StrPack *s, int64_t *ts) {
+if (s->size == 0) return NULL;
+const SPSlot *o = &s->slot[s->first + s->size - 1];
+if (ts) *ts = o->ts;
+char *p = (char*)malloc(o->len + 1);
+if (p) memcpy(p, s->bytes + o->off, o->len + 1);
+s->used = o->off;
+s->size--;
+if (s->size == 0) sp_clear(s);
+return p;
+}
+
+
+const char *sp_at(const StrPack *s, int i) {
+return s->bytes + s->slot[s->first + i].off;
+}
+
+
+size_t sp_len(const StrPack *s, int i) {
+return s->slot[s->first + i].len;
+}
+
+
+int64_t sp_ts(const StrPack *s, int i) {
+return s->slot[s->first + i].ts;
+}
+
+
+void sp_set_ts(StrPack *s, int i, int64_t ts) {
+s->slot[s->first + i].ts = ts;
+}
+
+
+int sp_full(const StrPack *s) { return s->cap >= 0 && s->size >= s->cap; }
+
+
+size_t sp_bytes(const StrPack *s) {
+return (s->used - s->dead) + (size_t)s->size * sizeof(SPSlot);
+}
@@ -1,6 +1,19 @@
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
 #include "bookmarks.h"
 #include "tabs.h"
+#include "trace.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+  #include <process.h>     // _getpid
+  #define getpid _getpid
+#else
+  #include <unistd.h>      // getpid
+#endif
+
+static atomic_int tm_instances;   // spill file names of managers sharing a process
 
 
 static void tm_reserve(TabManager *tm, int need) {
@@ -19,14 +32,111 @@ tm->back_cap_default = back_cap_default;
    vec_init(&tm->closed_json);
     tm->autosave = 0; tm->autosave_path[0] = '\0';
     bm_init(&tm->bookmarks);   
+    tm->spill_dir[0] = '\0'; tm->spill_seq = 0;
+    tm->spill_inst = atomic_fetch_add(&tm_instances, 1);
+    tm->next_uid = 1;
+    tm->unindexed = 0;
+    urlidx_init(&tm->search);
+    domidx_init(&tm->domains);
+    timeidx_init(&tm->times);
+    pred_init(&tm->pred);
+    memset(&tm->mem, 0, sizeof tm->mem);
+    tm->mem.bm_ver = tm->bookmarks.version - 1;
+    tm->view = NULL;
 
 }
 
 
-int tm_new_tab(TabManager *tm, const char *homepage) {
+void tm_set_spill_dir(TabManager *tm, const char *dir_or_null) {
+if (dir_or_null && *dir_or_null) {
+strncpy(tm->spill_dir, dir_or_null, sizeof tm->spill_dir - 1);
+tm->spill_dir[sizeof tm->spill_dir - 1] = '\0';
+} else {
+tm->spill_dir[0] = '\0';
+}
+}
+
+
+// one segment per tab, named by pid and manager so concurrent sessions
+// (processes or batch threads) can share a dir
+static void tm_attach_spill(TabManager *tm, Browser *b) {
+if (!tm->spill_dir[0] || b->cold) return;
+char path[400];
+snprintf(path, sizeof path, "%s/tab-%ld-%d-%d.seg", tm->spill_dir, (long)getpid(), tm->spill_inst, ++tm->spill_seq);
+browser_attach_cold(b, cold_open(path));
+}
+
+
+// keeps the manager-wide indexes in step with every tab
+static void tm_on_hist(void *ctx, Browser *b, int ev, const char *url, int64_t ts) {
+TabManager *tm = (TabManager*)ctx;
+if (ev == HIST_VISIT) { pred_visit(&tm->pred, b->current, url, b->clock); return; }   // the tab's latest stamp, close enough for the budget
+switch (ev) {
+// the time index borrows the search index's copy of the url, so it goes in after and out before
+case HIST_ADD:  timeidx_add(&tm->times, b, urlidx_add(&tm->search, b, url), ts); break;
+case HIST_DROP: timeidx_remove(&tm->times, b, url, ts); urlidx_remove(&tm->search, b, url); break;
+default: break;
+}
+domidx_event(&tm->domains, b, ev, url);
+tm_mem_touch(tm, b);
+}
+
+
+void tm_mem_touch(TabManager *tm, Browser *b) {
+MemBudget *m = &tm->mem;
+if (b->mem_queued) return;
+if (m->ndirty == m->dirty_cap) {
+m->dirty_cap = m->dirty_cap ? m->dirty_cap * 2 : 16;
+m->dirty = (Browser**)realloc(m->dirty, (size_t)m->dirty_cap * sizeof(Browser*));
+}
+m->dirty[m->ndirty++] = b;
+b->mem_queued = 1;
+}
+
+
+// a tab leaving the manager takes its charge along and must not stay queued
+static void tm_mem_forget(TabManager *tm, Browser *b) {
+MemBudget *m = &tm->mem;
+m->tabs -= b->mem;
+b->mem = 0;
+if (!b->mem_queued) return;
+for (int i = m->ndirty - 1; i >= 0; --i)
+if (m->dirty[i] == b) { m->dirty[i] = m->dirty[--m->ndirty]; break; }
+b->mem_queued = 0;
+}
+
+
+void tm_rebind(TabManager *tm) {
+for (int i = 0; i < tm->count; ++i) tm->tabs[i]->hook_ctx = tm;
+}
+
+
+int tm_bookmark_add(TabManager *tm, const char *name, const char *url) {
+int idx = bm_add(&tm->bookmarks, name, url);
+if (!tm->unindexed) urlidx_add(&tm->search, NULL, tm->bookmarks.data[idx].url);
+return idx;
+}
+
+
+// The tab is trimmed to the cap before it is announced, so entries dropped on
+// the way in never reach the indexes (a loaded session would otherwise index
+// and unindex most of its history).
+static void tm_bind(TabManager *tm, Browser *b, int id) {
+b->hook = NULL;
+b->mem = 0; b->mem_queued = 0;   // charges and queues belong to the previous owner
+b->uid = tm->next_uid++;
+b->id = id;
+tm_attach_spill(tm, b);
+browser_fit_back(b, tm->back_cap_default);
+if (tm->unindexed) return;
+b->hook = tm_on_hist; b->hook_ctx = tm;
+browser_announce(b);
+}
+
+
+int tm_adopt_tab(TabManager *tm, Browser *b) {
 tm_reserve(tm, tm->count + 1);
-Browser *b = (Browser*)malloc(sizeof(Browser));
-browser_init(b, homepage, tm->back_cap_default);
+tm_bind(tm, b, tm->count);
 tm->tabs[tm->count] = b;
 int id = tm->count;
 tm->count++;
@@ -35,15 +145,38 @@ return id;
 }
 
 
+void tm_replace_tab(TabManager *tm, int id, Browser *b) {
+if (id < 0 || id >= tm->count) return;
+Browser *old = tm->tabs[id];
+browser_forget(old);
+tm_mem_forget(tm, old);
+browser_destroy(old);
+free(old);
+tm_bind(tm, b, id);
+tm->tabs[id] = b;
+}
+
+
+int tm_new_tab(TabManager *tm, const char *homepage) {
+Browser *b = (Browser*)malloc(sizeof(Browser));
+browser_init(b, homepage, tm->back_cap_default);
+return tm_adopt_tab(tm, b);
+}
+
+
 void tm_close_tab(TabManager *tm, int id) {
 if (id < 0 || id >= tm->count) return;
+TRACE_BEGIN(span, "tm_close_tab");
+browser_forget(tm->tabs[id]);
+tm_mem_forget(tm, tm->tabs[id]);
 browser_destroy(tm->tabs[id]);
 free(tm->tabs[id]);
-for (int i = id + 1; i < tm->count; ++i) tm->tabs[i-1] = tm->tabs[i];
+for (int i = id + 1; i < tm->count; ++i) { tm->tabs[i-1] = tm->tabs[i]; tm->tabs[i-1]->id = i-1; }
 tm->count--;
-if (tm->count == 0) { tm->active = -1; return; }
-if (tm->active == id) tm->active = (id >= tm->count) ? (tm->count - 1) : id;
+if (tm->count == 0) tm->active = -1;
+else if (tm->active == id) tm->active = (id >= tm->count) ? (tm->count - 1) : id;
 else if (tm->active > id) tm->active--;
+TRACE_END(span);
 }
 
 
@@ -67,5 +200,10 @@ free(tm->tabs[i]);
 free(tm->tabs);
 vec_clear_free(&tm->closed_json); vec_free(&tm->closed_json);
     bm_destroy(&tm->bookmarks);    // NEW
+    urlidx_free(&tm->search);
+    domidx_free(&tm->domains);
+    timeidx_free(&tm->times);
+    pred_free(&tm->pred);
+    free(tm->mem.dirty); tm->mem.dirty = NULL; tm->mem.ndirty = tm->mem.dirty_cap = 0;
     tm->tabs=NULL; tm->cap=tm->count=0; tm->active=-1;  
 }
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include <stdlib.h>
+#include <string.h>
+#include "timeidx.h"
+#include "browser.h"
+
+static int tv_cmp(const TVisit *a, const TVisit *b){
+    if (a->ts != b->ts) return a->ts < b->ts ? -1 : 1;
+    return a->uid < b->uid ? -1 : a->uid > b->uid;
+}
+
+static int tv_qcmp(const void *a, const void *b){ return tv_cmp((const TVisit*)a, (const TVisit*)b); }
+
+void timeidx_init(TimeIndex *ix){
+    ix->v = NULL; ix->n = ix->cap = ix->dead = 0;
+    ix->pend = NULL; ix->npend = ix->cpend = 0;
+}
+
+void timeidx_free(TimeIndex *ix){
+    free(ix->v); free(ix->pend);
+    timeidx_init(ix);
+}
+
+static void reserve(TVisit **v, int *cap, int need){
+    if (*cap >= need) return;
+    int c = *cap ? *cap : 256;
+    while (c < need) c <<= 1;
+    *v = (TVisit*)realloc(*v, (size_t)c * sizeof(TVisit));
+    *cap = c;
+}
+
+// fold the pending batch into the sorted array; the common case is a batch
+// that sorts entirely after the last entry, which is a plain append
+static void settle(TimeIndex *ix){
+    if (!ix->npend) return;
+    qsort(ix->pend, (size_t)ix->npend, sizeof(TVisit), tv_qcmp);
+    reserve(&ix->v, &ix->cap, ix->n + ix->npend);
+    if (ix->n == 0 || tv_cmp(&ix->v[ix->n - 1], &ix->pend[0]) <= 0){
+        memcpy(ix->v + ix->n, ix->pend, (size_t)ix->npend * sizeof(TVisit));
+        ix->n += ix->npend;
+    } else {   // merge from the back, in place
+        int i = ix->n - 1, j = ix->npend - 1, k = ix->n + ix->npend - 1;
+        while (j >= 0){
+            if (i >= 0 && tv_cmp(&ix->v[i], &ix->pend[j]) > 0) ix->v[k--] = ix->v[i--];
+            else ix->v[k--] = ix->pend[j--];
+        }
+        ix->n += ix->npend;
+    }
+    ix->npend = 0;
+}
+
+static void compact(TimeIndex *ix){
+    if (ix->dead < 1024 || ix->dead * 2 < ix->n) return;
+    int k = 0;
+    for (int i = 0; i < ix->n; ++i) if (ix->v[i].tab) ix->v[k++] = ix->v[i];
+    ix->n = k; ix->dead = 0;
+}
+
+void timeidx_add(TimeIndex *ix, struct Browser *tab, const char *url, int64_t ts){
+    if (!ts) return;
+    TVisit t = { ts, tab->uid, tab, url };
+    if (!ix->npend && (ix->n == 0 || tv_cmp(&ix->v[ix->n - 1], &t) <= 0)){
+        reserve(&ix->v, &ix->cap, ix->n + 1);
+        ix->v[ix->n++] = t;
+        return;
+    }
+    reserve(&ix->pend, &ix->cpend, ix->npend + 1);
+    ix->pend[ix->npend++] = t;
+}
+
+// first entry not ordered before (ts, uid)
+static int lower_bound(const TimeIndex *ix, int64_t ts, unsigned uid){
+    TVisit key = { ts, uid, NULL, NULL };
+    int lo = 0, hi = ix->n;
+    while (lo < hi){
+        int mid = (lo + hi) / 2;
+        if (tv_cmp(&ix->v[mid], &key) < 0) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+// Removals never force a merge: the entry is either in the sorted array or
+// still pending, and pending ones are usually the tab's own recent arrivals
+// (a loaded tab trimmed to the back cap), so that batch is scanned from the end.
+// A tab can hold several visits with one stamp; the url picks the right one,
+// since each borrows its own url's copy.
+void timeidx_remove(TimeIndex *ix, struct Browser *tab, const char *url, int64_t ts){
+    if (!ts) return;
+    for (int i = lower_bound(ix, ts, tab->uid); i < ix->n && ix->v[i].ts == ts && ix->v[i].uid == tab->uid; ++i){
+        if (ix->v[i].tab != tab || strcmp(ix->v[i].url, url)) continue;
+        ix->v[i].tab = NULL; ix->v[i].url = NULL;
+        ix->dead++;
+        compact(ix);
+        return;
+    }
+    for (int i = ix->npend - 1; i >= 0; --i){
+        if (ix->pend[i].tab != tab || ix->pend[i].ts != ts || strcmp(ix->pend[i].url, url)) continue;
+        ix->pend[i] = ix->pend[--ix->npend];
+        return;
+    }
+}
+
+int timeidx_query(TimeIndex *ix, int64_t since, int64_t until, TVisit **out){
+    settle(ix);
+    int n = 0, cap = 0;
+    *out = NULL;
+    for (int i = lower_bound(ix, since, 0); i < ix->n && ix->v[i].ts <= until; ++i){
+        if (!ix->v[i].tab) continue;
+        if (n == cap){ cap = cap ? cap * 2 : 64; *out = (TVisit*)realloc(*out, (size_t)cap * sizeof(TVisit)); }
+        (*out)[n++] = ix->v[i];
+    }
+    return n;
+}
+
+int timeidx_count(TimeIndex *ix){
+    settle(ix);
+    return ix->n - ix->dead;
+}
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+
+#ifdef BROWSER_TRACE
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define TRACE_RING (1 << 16)   // events kept per thread, oldest overwritten
+
+typedef struct {
+    const char *name;          // static string from the trace point
+    uint64_t ts, dur;          // ns
+    char arg[24];
+} TraceEv;
+
+// One per thread that has recorded anything. Only the owner writes; head is
+// published with release so a dump sees whole events. A dump racing a busy
+// writer can still catch the oldest slot being reused.
+typedef struct TraceRing {
+    TraceEv ev[TRACE_RING];
+    _Atomic uint64_t head;     // events ever written
+    _Atomic uint64_t start;    // first event a dump shows (trace_clear)
+    int tid;
+    struct TraceRing *next;
+} TraceRing;
+
+atomic_int trace_enabled_;
+static _Atomic(TraceRing*) rings;
+static atomic_int ring_count;
+static _Thread_local TraceRing *mine;
+
+uint64_t trace_now(void) {
+#if defined(_WIN32) || defined(_WIN64)
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER c;
+    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&c);
+    return (uint64_t)(c.QuadPart / freq.QuadPart) * 1000000000u
+         + (uint64_t)(c.QuadPart % freq.QuadPart) * 1000000000u / (uint64_t)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+// rings are never freed: a thread's events stay dumpable after it exits
+static TraceRing *ring_new(void) {
+    TraceRing *r = (TraceRing*)calloc(1, sizeof(TraceRing));
+    if (!r) return NULL;
+    r->tid = atomic_fetch_add(&ring_count, 1) + 1;
+    TraceRing *h = atomic_load(&rings);
+    do r->next = h; while (!atomic_compare_exchange_weak(&rings, &h, r));
+    return mine = r;
+}
+
+void trace_record(const char *name, uint64_t t0, const char *arg) {
+    uint64_t t1 = trace_now();
+    TraceRing *r = mine ? mine : ring_new();
+    if (!r) return;
+    uint64_t h = atomic_load_explicit(&r->head, memory_order_relaxed);
+    TraceEv *e = &r->ev[h & (TRACE_RING - 1)];
+    e->name = name; e->ts = t0; e->dur = t1 - t0;
+    size_t n = 0;
+    // keep the argument JSON-safe as it is copied; a line ending ends it
+    if (arg) for (; arg[n] && arg[n] != '\n' && arg[n] != '\r' && n < sizeof e->arg - 1; ++n)
+        e->arg[n] = (arg[n] == '"' || arg[n] == '\\' || (unsigned char)arg[n] < 0x20) ? '_' : arg[n];
+    e->arg[n] = '\0';
+    atomic_store_explicit(&r->head, h + 1, memory_order_release);
+}
+
+int  trace_available(void) { return 1; }
+void trace_set(int on) { atomic_store(&trace_enabled_, on ? 1 : 0); }
+int  trace_is_on(void) { return atomic_load(&trace_enabled_); }
+
+void trace_clear(void) {
+    for (TraceRing *r = atomic_load(&rings); r; r = r->next)
+        atomic_store(&r->start, atomic_load_explicit(&r->head, memory_order_acquire));
+}
+
+static uint64_t first_event(TraceRing *r, uint64_t head) {
+    uint64_t from = atomic_load(&r->start);
+    if (head - from > TRACE_RING) from = head - TRACE_RING;
+    return from;
+}
+
+int trace_dump(const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+    // timestamps are shown relative to the earliest start kept; events are
+    // recorded as they end, so that is not necessarily the first slot
+    uint64_t base = UINT64_MAX;
+    for (TraceRing *r = atomic_load(&rings); r; r = r->next) {
+        uint64_t h = atomic_load_explicit(&r->head, memory_order_acquire);
+        for (uint64_t i = first_event(r, h); i < h; ++i)
+            if (r->ev[i & (TRACE_RING - 1)].ts < base) base = r->ev[i & (TRACE_RING - 1)].ts;
+    }
+    int n = 0;
+    fputs("{\"traceEvents\":[", f);
+    for (TraceRing *r = atomic_load(&rings); r; r = r->next) {
+        uint64_t h = atomic_load_explicit(&r->head, memory_order_acquire);
+        for (uint64_t i = first_event(r, h); i < h; ++i) {
+            const TraceEv *e = &r->ev[i & (TRACE_RING - 1)];
+            fprintf(f, "%s\n{\"name\":\"%s\",\"cat\":\"browser\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                    n ? "," : "", e->name, r->tid, (double)(e->ts > base ? e->ts - base : 0) / 1000.0, (double)e->dur / 1000.0);
+            if (e->arg[0]) fprintf(f, ",\"args\":{\"arg\":\"%s\"}", e->arg);
+            fputc('}', f);
+            n++;
+        }
+    }
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", f);
+    if (fclose(f) != 0) return -1;
+    return n;
+}
+
+#else   // tracing compiled out
+
+int  trace_available(void) { return 0; }
+void trace_set(int on) { (void)on; }
+int  trace_is_on(void) { return 0; }
+void trace_clear(void) {}
+int  trace_dump(const char *path) { (void)path; return -1; }
+
+#endif
@@ -1,5 +1,6 @@
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "util.h"
 
 
@@ -9,4 +10,34 @@ size_t n = strlen(s) + 1;
 char *p = (char*)malloc(n);
 if (p) memcpy(p, s, n);
 return p;
-}
\ No newline at end of file
+}
+
+uint64_t fnv1a64(const void *p, size_t n, uint64_t h) {
+const unsigned char *s = (const unsigned char*)p;
+for (size_t i = 0; i < n; ++i) { h ^= s[i]; h *= 0x100000001b3ULL; }
+return h;
+}
+
+int64_t wall_ms(void) {
+struct timespec ts;
+if (!timespec_get(&ts, TIME_UTC)) return 0;
+return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int parse_bytes(const char *s, size_t *out) {
+char *end;
+unsigned long long v = strtoull(s, &end, 10);
+if (end == s || *s == '-') return 0;
+int shift = 0;
+switch (*end) {
+case 'k': case 'K': shift = 10; break;
+case 'm': case 'M': shift = 20; break;
+case 'g': case 'G': shift = 30; break;
+case '\0': break;
+default: return 0;
+}
+if (*end && end[1] && !((end[1] == 'b' || end[1] == 'B') && !end[2])) return 0;
+if (v > (SIZE_MAX >> shift)) return 0;
+*out = (size_t)(v << shift);
+return 1;
+}
@@ -0,0 +1,33 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+
+// Runs every *.txt script in a directory inside one process, each against
+// its own TabManager/UndoStack, on a small work-stealing thread pool: scripts
+// are dealt out in contiguous runs and a worker whose run is used up takes
+// the back half of the next non-empty one. A script's output goes to
+// <out_dir>/<name>.out and its final session to <out_dir>/<name>.session.json.
+// Paths a script names itself (save, autosave, trace dump) are used as
+// written, so scripts sharing a directory should not share those.
+
+typedef struct {
+    const char *dir;         // scripts to run
+    const char *out_dir;     // NULL: next to the scripts
+    int threads;             // <= 0: one per online CPU
+    int back_cap;
+    const char *spill_dir;   // NULL: no cold tier
+    size_t mem_limit;        // per script, 0: none
+} BatchOpts;
+
+typedef struct {
+    int scripts, failed;     // failed: unreadable script or unwritable output
+    long commands;
+    int threads, steals;
+    double secs;
+} BatchStats;
+
+int batch_run(const BatchOpts *o, BatchStats *st);   // 0, or -1 when dir cannot be listed
+int batch_default_threads(void);
+
+#endif
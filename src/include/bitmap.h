@@ -0,0 +1,33 @@
+#ifndef BITMAP_H
+#define BITMAP_H
+
+#include <stdint.h>
+
+// Compressed bitmap over uint32 ids, roaring-style: ids are bucketed by their
+// high 16 bits into containers that hold the low 16 bits either as a sorted
+// array (sparse, up to 4096 ids) or as a 65536-bit set (dense). Set algebra
+// works container by container and picks the cheaper form for each result.
+typedef struct {
+    uint16_t  key;     // high 16 bits
+    int       card;
+    int       cap;     // array capacity, 0 for a bitset container
+    uint16_t *arr;     // sorted low bits, NULL when dense
+    uint64_t *bits;    // 1024 words, NULL when sparse
+} RCont;
+
+typedef struct { RCont *c; int n, cap; } Bitmap;
+
+void     bmp_init(Bitmap *b);
+void     bmp_free(Bitmap *b);
+void     bmp_add(Bitmap *b, uint32_t x);
+void     bmp_remove(Bitmap *b, uint32_t x);
+int      bmp_contains(const Bitmap *b, uint32_t x);
+uint32_t bmp_count(const Bitmap *b);
+void     bmp_fill(Bitmap *b, uint32_t n);                              // {0..n-1}
+void     bmp_copy(Bitmap *dst, const Bitmap *src);
+void     bmp_and(Bitmap *out, const Bitmap *a, const Bitmap *b);      // out must not alias a or b
+void     bmp_or(Bitmap *out, const Bitmap *a, const Bitmap *b);
+void     bmp_andnot(Bitmap *out, const Bitmap *a, const Bitmap *b);
+uint32_t bmp_to_array(const Bitmap *b, uint32_t **out);                // ascending, *out malloc'd
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef BMIMPORT_H
+#define BMIMPORT_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include "bookmarks.h"
+
+// Streaming reader for bookmark exports: Netscape HTML (what every browser
+// exports) and JSON (Chrome's Bookmarks file, Firefox backups, and our own
+// [{"name","url","folder","tags"}] lists). Bytes are fed in arbitrary chunks;
+// a token split across two chunks is carried over, so the text held at once
+// is the longest single tag or string, not the file. JSON also keeps, until
+// close, one int per imported bookmark and one entry per folder: a folder's
+// name can follow its children, so folder paths are joined last.
+
+// adds one bookmark, returns its index (tm_bookmark_add, or bm_add directly)
+typedef int (*BMAddFn)(void *ctx, const char *name, const char *url);
+
+typedef struct BMImport BMImport;
+
+BMImport *bmi_open(BMList *bm, BMAddFn add, void *ctx);
+int       bmi_feed(BMImport *im, const char *p, size_t n);   // 0 once the input is malformed
+int       bmi_close(BMImport *im);                           // bookmarks added, -1 if malformed
+
+// whole stream in fixed-size chunks, with the list in bulk mode
+int       bm_import_stream(BMList *bm, FILE *f, BMAddFn add, void *ctx);
+
+#endif
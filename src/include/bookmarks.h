@@ -3,19 +3,55 @@
 
 #include "util.h"
 #include "vec.h"
+#include "hmap.h"
+#include "bitmap.h"
 #include <stdio.h>
-typedef struct { char *name; char *url; } BMItem;
+
+// folder/tags point at the interned label names owned by the BMList
+typedef struct {
+    char *name; char *url;
+    const char *folder;      // NULL at top level
+    const char **tags; int ntags;
+} BMItem;
+
+// a tag or folder: its name and the ids of the bookmarks carrying it
+typedef struct { char *name; Bitmap ids; } BMLabel;
 
 typedef struct {
     BMItem *data;
     int size, cap;
+    StrMap tags;             // tag name -> BMLabel*
+    StrMap folders;          // folder name -> BMLabel*
+    StrMap by_name;          // name -> first index + 1, rebuilt once after a bulk load
+    int bulk;                // inside bm_bulk_begin/end: by_name is not maintained
+    unsigned version;        // bumped on every change
+    char *frag; size_t frag_len; unsigned frag_ver;   // cached session JSON, see session.c
 } BMList;
 
+// bm list filter: every `all` tag, at least one `any` tag (when given),
+// no `none` tag, and inside `folder` (when set)
+typedef struct {
+    const char **all;  int nall;
+    const char **any;  int nany;
+    const char **none; int nnone;
+    const char *folder;
+} BMQuery;
+
 void bm_init(BMList *bm);
 void bm_destroy(BMList *bm);
+void bm_reserve(BMList *bm, int need);
 int  bm_add(BMList *bm, const char *name, const char *url);  // returns index
 int  bm_find_by_name(const BMList *bm, const char *name);     // -1 if not found
 const BMItem* bm_get(const BMList *bm, int idx);
+void bm_bulk_begin(BMList *bm, int expect);                 // reserve, stop per-item name indexing
+void bm_bulk_end(BMList *bm);                               // index the names in one pass
+
+int  bm_tag(BMList *bm, int idx, const char *tag);            // 1 if newly tagged
+int  bm_untag(BMList *bm, int idx, const char *tag);          // 1 if it had the tag
+void bm_set_folder(BMList *bm, int idx, const char *folder);  // NULL or "" = top level
+const BMLabel* bm_tag_label(const BMList *bm, const char *tag);
+const BMLabel* bm_folder_label(const BMList *bm, const char *folder);
+void bm_query(const BMList *bm, const BMQuery *q, Bitmap *out);
 
 // --- session helpers (JSON) ---
 void bm_save_json(FILE *f, const BMList *bm);                 // writes [...], no key
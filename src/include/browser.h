@@ -2,23 +2,85 @@
 #define BROWSER_H
 
 
-#include "ring.h"
-#include "vec.h"
+#include "strpack.h"
+#include "cold.h"
 
 
-typedef struct {
+struct Browser;
+
+// A forward stack that a new visit cut off: the page it leads on from and
+// the pages themselves, laid out like Browser.fwd (index 0 is the far end).
+// Immutable once archived and refcounted, so a duplicated tab shares its
+// branches with the original instead of copying them. A session file keeps
+// one copy of each, named by id, that every tab holding it refers to.
+typedef struct Branch {
+int refs;
+unsigned id; // unique in the process, never reused
+char *frag; size_t frag_len; // cached session JSON, see session.c
+char *at; // the page the branch leads on from
+int64_t at_ts;
+StrPack pages;
+int64_t ts; // newest stamp among the pages, for LRU eviction
+} Branch;
+
+#define BROWSER_BRANCHES 16 // per tab, the oldest goes first
+
+Branch *branch_new(const char *at, int64_t at_ts, StrPack *pages); // takes over pages
+void branch_release(Branch *br); // drop one reference
+
+// History events, so an owner can keep indexes in step with a tab:
+// ADD/DROP — a url entered/left the tab's history (current, back or forward),
+// ENTER/LEAVE — a url became/stopped being the current page,
+// VISIT — browser_visit is about to go from current to url (before the rest).
+// ts is the entry's visit time (see current_ts), 0 when unknown.
+enum { HIST_ADD, HIST_DROP, HIST_ENTER, HIST_LEAVE, HIST_VISIT };
+typedef void (*HistHook)(void *ctx, struct Browser *b, int ev, const char *url, int64_t ts);
+
+
+typedef struct Browser {
 char *current;
-Ring back; // capped ring buffer
-Vec fwd; // forward stack
+int64_t current_ts; // when current was visited: wall-clock ms, 0 = unknown
+int64_t clock; // last stamp handed out; keeps this tab's stamps increasing
+StrPack back; // capped, packed ring of older pages (hot tier)
+StrPack fwd; // packed forward stack
+ColdSeg *cold; // optional on-disk tier below back, NULL = drop evictions
+HistHook hook; // optional, see HIST_*
+void *hook_ctx;
+int id; // slot in the owning TabManager
+unsigned uid; // stable per-manager serial
+uint64_t tab_id; // identity across sessions, saved as "tab_id": kept by save/load and reopen, fresh for a new or duplicated tab
+unsigned version; // bumped on every history change
+char *frag; // cached serialized tab, valid while frag_ver == version
+size_t frag_len;
+unsigned frag_ver;
+uint64_t hash; // content hash of the whole history,
+unsigned hash_ver; // valid while hash_ver == version
+Branch **branches; // abandoned forward stacks, oldest first
+int nbranches;
+size_t mem; // bytes charged to the owner's memory budget
+int mem_queued; // waiting in the owner's list of tabs to re-charge
 } Browser;
 
 
 void browser_init(Browser *b, const char *homepage, int back_cap);
-void browser_destroy(Browser *b);
+void browser_destroy(Browser *b); // silent: fires no hook events
+void browser_attach_cold(Browser *b, ColdSeg *c); // takes ownership
+void browser_fit_back(Browser *b, int back_cap); // re-cap back, spilling or dropping overflow
+int browser_back_total(const Browser *b); // hot + cold back entries
+void browser_sync_clock(Browser *b); // clock = newest stamp in the history (after load)
+int64_t browser_last_ts(const Browser *b); // newest stamp in the history
+uint64_t browser_hash(Browser *b); // history content hash (urls and position), cached
+void browser_announce(Browser *b); // ADD every entry + ENTER current
+void browser_forget(Browser *b); // DROP every entry + LEAVE current
+size_t browser_mem(const Browser *b); // resident bytes: current, hot back, forward, cached fragment
+int64_t browser_evict_ts(const Browser *b); // stamp of what browser_evict takes next, INT64_MAX if nothing
+int browser_evict(Browser *b); // oldest resident entry or branch, never current: entries dropped, -1 spilled, 0 none
+Browser *browser_clone(Browser *b); // same history, fresh identity; shares the branches
+int browser_restore_branch(Browser *b, int i); // move to branch i's page and make its pages the forward stack: 1, 0 no such branch, -1 its page has left the history
 const char *browser_visit(Browser *b, const char *url);
 const char *browser_back(Browser *b, int steps);
 const char *browser_forward(Browser *b, int steps);
 const char *browser_current(const Browser *b);
 
 
-#endif // BROWSER_H
\ No newline at end of file
+#endif // BROWSER_H
@@ -0,0 +1,29 @@
+#ifndef COLD_H
+#define COLD_H
+
+#include <stdio.h>
+#include "strpack.h"
+
+// On-disk cold tier for a tab's back history. Entries evicted from the hot
+// StrPack are appended to a segment file as [u32 len][i64 ts][bytes] records; a
+// compact index file holds one u64 record offset per entry. Records for
+// entries 0..count-1 are always contiguous, so paging the newest k entries
+// back in is one index read plus one data read.
+#define COLD_PAGE 256   // entries per read when walking the whole tier
+
+typedef struct {
+    FILE *data;
+    FILE *idx;
+    char  path[260];     // segment path; the index lives at path + ".idx"
+    int   count;         // entries on disk, oldest..newest
+    long  end;           // data offset just past the newest record
+    int   failed;        // appends that could not be written; the caller kept those entries
+} ColdSeg;
+
+ColdSeg *cold_open(const char *path);                        // creates/truncates, NULL on failure
+void cold_close(ColdSeg *c);                                  // closes and removes both files
+int  cold_append(ColdSeg *c, const char *s, size_t n, int64_t ts); // 1 on success, 0 counted in failed
+int  cold_read_range(ColdSeg *c, int from, int n, StrPack *dst); // pushes entries from..from+n-1
+int  cold_pop_tail(ColdSeg *c, int n, StrPack *dst);          // moves the newest n entries into dst
+
+#endif
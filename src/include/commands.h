@@ -0,0 +1,12 @@
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include <stdio.h>
+#include "tabs.h"
+#include "features.h"
+
+void print_help(FILE *out);
+/* returns 1 to continue loop, 0 to exit; command output goes to out */
+int process_command(TabManager *tm, UndoStack *undo, const char *cmdline, FILE *out);
+
+#endif
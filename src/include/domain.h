@@ -0,0 +1,34 @@
+#ifndef DOMAIN_H
+#define DOMAIN_H
+
+#include <stddef.h>
+#include "hmap.h"
+
+struct Browser;
+
+// host of a url, lowercased, without scheme, userinfo, port or a leading
+// "www."; returns 0 (and "") when the url has no host, e.g. about:blank
+int url_host(const char *url, char *out, size_t n);
+
+// Per-host view of the session: which tabs currently show the host and how
+// many history entries (current, back, forward) point at it. Maintained from
+// history events, so queries cost the size of the answer.
+typedef struct {
+    char *host;
+    struct Browser **tabs;   // tabs whose current page is on host
+    int ntabs, ctabs;
+    long history;            // entries on host across all tabs
+} DomainEnt;
+
+typedef struct {
+    StrMap by_host;          // host -> DomainEnt*
+    U64Map slot;             // tab uid -> index in its host's tabs + 1
+} DomainIndex;
+
+void domidx_init(DomainIndex *dx);
+void domidx_free(DomainIndex *dx);
+void domidx_event(DomainIndex *dx, struct Browser *b, int ev, const char *url);   // HIST_* from browser.h
+const DomainEnt *domidx_get(const DomainIndex *dx, const char *host);
+int  domidx_top(const DomainIndex *dx, const DomainEnt ***out);   // all hosts by history, desc; *out malloc'd
+
+#endif
@@ -7,16 +7,33 @@
 
 typedef struct {
     Vec blobs;  // vector<char*>
+    size_t bytes;   // held by the blobs
 } UndoStack;
 
 void undo_init(UndoStack *u);
 void undo_destroy(UndoStack *u);
-void undo_push_tab(UndoStack *u, const Browser *b);                 // serialize + push
+void undo_push_tab(UndoStack *u, Browser *b);                       // serialize + push
 int  undo_reopen_top(UndoStack *u, TabManager *tm);                  // returns new tab id or -1
 
 //  command if enabled
 void autosave_on (TabManager *tm, const char *path_or_null);
 void autosave_off(TabManager *tm);
-void autosave_maybe(const TabManager *tm);
+void autosave_maybe(const TabManager *tm);   // tabs and bookmarks only
+void autosave_final(const TabManager *tm);   // at exit: the next-visit model too
+
+// Memory budget (TabManager.mem): charges the tabs queued since the last
+// call, the undo stack, the bookmarks and the next-visit model. Over the
+// limit, resident history goes in global LRU order, oldest stamp across all
+// tabs first (spilled to the cold tier when there is one, dropped otherwise;
+// archived branches go whole), never a current page, and with it the
+// model's rows by when they last changed, until usage is back under 7/8 of
+// the limit; closed tabs on undo go only if that is not enough. Run after
+// every command by process_command.
+void mem_settle(TabManager *tm, UndoStack *undo);
+size_t mem_used(const TabManager *tm);
+
+// Rewrites tm->view (shmview.h) from the manager's current state, only the
+// tab slots that changed; run after every command by process_command.
+void view_publish(TabManager *tm, const UndoStack *undo);
 
 #endif
@@ -0,0 +1,30 @@
+#ifndef HMAP_H
+#define HMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Open-addressing hash maps (linear probing, tombstones, power-of-two sizes).
+// StrMap does not own its keys: the caller keeps each key alive while mapped.
+
+typedef struct { const char *key; uint64_t hash; void *val; } SMSlot;
+typedef struct { SMSlot *slots; int cap, count, used; } StrMap;
+
+void   sm_init(StrMap *m);
+void   sm_free(StrMap *m);
+void **sm_get(const StrMap *m, const char *key);            // NULL if absent
+void **sm_put(StrMap *m, const char *key, int *created);    // inserts NULL val if absent
+int    sm_del(StrMap *m, const char *key);                  // 1 if removed
+int    sm_live(const SMSlot *s);                            // occupied slot (for iteration)
+void   sm_reserve(StrMap *m, int n);                        // room for n more keys without rehashing
+
+typedef struct { uint64_t key; void *val; unsigned char state; } UMSlot;
+typedef struct { UMSlot *slots; int cap, count, used; } U64Map;
+
+void   um_init(U64Map *m);
+void   um_free(U64Map *m);
+void **um_get(const U64Map *m, uint64_t key);
+void **um_put(U64Map *m, uint64_t key, int *created);
+int    um_del(U64Map *m, uint64_t key);
+
+#endif
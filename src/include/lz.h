@@ -0,0 +1,28 @@
+#ifndef LZ_H
+#define LZ_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+// Streaming LZ container for session files. After the 4-byte magic the
+// stream is a sequence of blocks [u32 raw_len][u32 stored_len][payload],
+// ending with a zero raw_len. Payloads use an LZ4-style byte codec whose
+// matches may reach 64 KiB back into the previous block, so redundancy
+// across tabs is found without either side holding more than one block
+// plus that window. The top bit of stored_len marks an uncompressed block.
+#define LZ_MAGIC     "BLZ1"
+#define LZ_MAGIC_LEN 4
+#define LZ_BLOCK     (64 * 1024)
+
+typedef struct LzWriter LzWriter;
+typedef struct LzReader LzReader;
+
+LzWriter *lzw_open(FILE *f);                          // writes the magic
+int       lzw_write(LzWriter *w, const void *p, size_t n);
+int       lzw_close(LzWriter *w);                     // flushes + end marker; 1 if every write succeeded
+LzReader *lzr_open(FILE *f);                          // call with the magic already consumed
+size_t    lzr_read(LzReader *r, void *p, size_t n);   // 0 at end of stream or on error
+int       lzr_error(const LzReader *r);
+void      lzr_close(LzReader *r);                     // does not close f
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef PREDICT_H
+#define PREDICT_H
+
+#include <stdint.h>
+#include "hmap.h"
+
+#define PRED_K 8   // successors kept per url
+
+// Next-visit model: for every url, the urls visited right after it (in the
+// same tab) with how often. Each url keeps only its PRED_K most frequent
+// successors, counted with the space-saving scheme: an unseen successor
+// takes the place of the least frequent one and inherits its count, which
+// becomes the new entry's error bound. Successors are kept sorted, so a
+// prediction is one hash lookup and a prefix of a fixed-size array.
+//
+// A url that is only ever a successor has an empty row that lives while
+// some row points at it. Under a memory budget whole rows are forgotten,
+// least recently updated first (mem_settle in features.h).
+typedef struct PredRow PredRow;
+typedef struct { PredRow *to; uint32_t n, err; } PredNext;   // n overcounts by at most err
+
+struct PredRow {
+    char *url;
+    uint32_t total;            // transitions counted out of url
+    int nnext;
+    PredNext next[PRED_K];     // most frequent first
+    int refs;                  // successor slots pointing here
+    int64_t ts;                // last update, in history stamps (wall ms)
+};
+
+typedef struct {
+    StrMap rows;               // url -> PredRow*, keyed by the row's own copy
+    int count;
+    unsigned version;          // bumped on every change
+    size_t bytes;              // rows and their urls, not the map
+} Predictor;
+
+void pred_init(Predictor *p);
+void pred_free(Predictor *p);
+void pred_visit(Predictor *p, const char *from, const char *to, int64_t ts);
+PredRow *pred_row(Predictor *p, const char *url);             // created empty if absent
+const PredRow *pred_get(const Predictor *p, const char *url); // NULL if never seen
+
+size_t pred_mem(const Predictor *p);
+int    pred_forget(Predictor *p, PredRow *r);   // drops r's successors; urls forgotten, r itself when nothing points at it
+
+#endif
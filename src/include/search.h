@@ -0,0 +1,35 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdint.h>
+#include "hmap.h"
+
+struct Browser;
+
+// Trigram inverted index over every url held by the tabs (current, back,
+// forward) and the bookmarks. Each distinct url is one document; a document
+// remembers which tabs hold it and how often, so the index is maintained
+// with one add/remove per history event and never rescans a tab.
+typedef struct { struct Browser *tab; int count; } UrlRef;   // tab NULL: bookmark
+typedef struct { char *url; UrlRef *refs; int nrefs, crefs; } UrlDoc;   // url NULL: dead
+typedef struct { int *ids; int n, cap; } Posting;            // ascending doc ids
+typedef struct { uint32_t key; Posting post; } TriSlot;      // key = trigram + 1, 0 = empty
+
+typedef struct {
+    StrMap   by_url;     // url -> doc id + 1
+    U64Map   refpos;     // (doc id, tab uid) -> ref slot + 1
+    UrlDoc  *docs;
+    int      ndocs, cdocs, ndead;
+    TriSlot *tri;
+    int      tcap, tcount;
+} UrlIndex;
+
+typedef struct { struct Browser *tab; const char *url; } UrlHit;
+
+void urlidx_init(UrlIndex *ix);
+void urlidx_free(UrlIndex *ix);
+const char *urlidx_add(UrlIndex *ix, struct Browser *tab, const char *url);   // the index's copy of url, stable while referenced
+void urlidx_remove(UrlIndex *ix, struct Browser *tab, const char *url);
+int  urlidx_search(const UrlIndex *ix, const char *sub, UrlHit **out);  // case-insensitive; *out malloc'd
+
+#endif
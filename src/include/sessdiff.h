@@ -0,0 +1,39 @@
+#ifndef SESSDIFF_H
+#define SESSDIFF_H
+
+#include "tabs.h"
+#include "features.h"
+
+// Tab-level comparison of two sessions. Tabs are paired through hash maps,
+// first by tab_id (the same tab, saved, loaded and maybe browsed further on
+// one side), then the leftovers by a 64-bit hash of their history
+// (browser_hash, cached per tab version); a paired tab is "same" when the
+// histories hash equal and "changed" otherwise. Anything left unpaired
+// exists on one side only. A diff costs about as much as hashing both sides.
+
+typedef struct { int a, b; } TabPair;   // tab ids in each session
+
+typedef struct {
+    TabPair *same;    int nsame;
+    TabPair *changed; int nchanged;
+    int *only_a;      int nonly_a;
+    int *only_b;      int nonly_b;
+} SessionDiff;
+
+void session_diff(TabManager *a, TabManager *b, SessionDiff *d);
+void session_diff_free(SessionDiff *d);
+
+// session file into a scratch manager: no indexes, no back cap, no spill
+int  session_load_scratch(const char *path, TabManager *out);
+
+typedef struct { int added, updated, kept, pruned; } MergeStats;
+
+// Brings from's tabs into live: tabs only in from are appended, changed tabs
+// take whichever side was visited last, tabs only in live stay unless prune
+// is set. A live tab that is overwritten or pruned goes onto undo first, so
+// `reopen` brings it back.
+// Tabs moved into live are taken out of from.
+void session_merge(TabManager *live, TabManager *from, const SessionDiff *d,
+                   int prune, UndoStack *undo, MergeStats *st);
+
+#endif
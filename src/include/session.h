@@ -2,14 +2,31 @@
 #define SESSION_H
 
 
+#include <stdio.h>
 #include "tabs.h"
 
 
+// paths ending in ".lz" are written as an LZ container; load detects it by magic
 int save_session_json(const char *path, const TabManager *tm);
-int load_session_json(const char *path, TabManager *tm, int back_cap_default);
+// the same without the next-visit model, for autosave after every command
+int save_session_json_nomodel(const char *path, const TabManager *tm);
+int load_session_json(const char *path, TabManager *tm, int back_cap_default);   // "-" reads stdin
+int load_session_file(FILE *f, TabManager *tm, int back_cap_default);             // no seeking, pipes ok
+int load_session_fd(int fd, TabManager *tm, int back_cap_default);
+int session_path_compressed(const char *path);
+
+// Incremental loader: feed any number of byte chunks, then close. On a
+// successful close (commit != 0 and a complete document) tm is replaced;
+// otherwise tm is left as it was.
+typedef struct SessionLoader SessionLoader;
+SessionLoader *session_loader_open(TabManager *tm, int back_cap_default);
+int  session_loader_feed(SessionLoader *ld, const void *data, size_t n);  // 0 once malformed
+int  session_loader_close(SessionLoader *ld, int commit);
 
 // NEW: serialize a single Browser (JSON object) to a malloc'd string
 char *session_serialize_tab_json(const Browser *b);
+// cached serialization of one tab, rebuilt only when b->version changed (owned by b)
+const char *session_tab_fragment(Browser *b, size_t *len);
 // NEW: parse a single Browser JSON object blob into a Browser*
 int session_deserialize_tab_json(const char *obj_json, Browser **out, int back_cap_default);
 
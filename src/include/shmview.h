@@ -0,0 +1,65 @@
+#ifndef SHMVIEW_H
+#define SHMVIEW_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+// Read-only session view in POSIX shared memory (browser --shm <name>), for
+// monitors that would otherwise re-read session.json after every autosave.
+// The browser rewrites the view after each command under a seqlock: the
+// sequence number is odd while an update is in progress, and a reader whose
+// copy started and ended on the same even number has a consistent snapshot.
+// Readers never block the browser and need no lock; a snapshot is one copy
+// of the header and the open tabs' slots.
+//
+// shmview.c depends on nothing else in the tree: a monitor builds it with
+// this header and calls shmview_attach/shmview_read/shmview_detach (see
+// tools/shmwatch.c). On Windows the calls compile but fail.
+
+#define SHMV_MAGIC 0x31564853u   // "SHV1"
+#define SHMV_TABS  256           // tab slots; count may be larger
+#define SHMV_URL   256           // bytes kept of each url, NUL included
+
+typedef struct {
+    char url[SHMV_URL];          // current page, cut to fit
+    uint32_t url_len;            // full length, > SHMV_URL - 1 when cut
+    int32_t back, forward;       // history depth, cold back entries included
+    int64_t ts;                  // current page's visit time, ms, 0 = unknown
+    uint32_t uid, version;       // the tab, and its history version: unchanged pair, unchanged slot
+} ShmViewTab;
+
+typedef struct {
+    int32_t live;                // 0 once the browser has exited
+    int32_t pid;
+    uint64_t updates;            // snapshots published so far
+    int64_t updated_ms;          // wall clock of this one
+    int32_t count, active;       // tabs open, active id (-1: none)
+    int32_t bookmarks, closed;   // bookmarks, closed tabs on undo
+    uint64_t mem_used, mem_limit;             // bytes, limit 0 = none
+    int64_t evicted, spilled, undo_dropped;   // memory budget counters
+    int32_t predicted;           // urls in the next-visit model
+    int32_t pad_;
+    ShmViewTab tab[SHMV_TABS];   // the first min(count, SHMV_TABS) tabs, by id
+} ShmViewData;
+
+typedef struct {
+    uint32_t magic, size;        // size: sizeof(ShmViewSeg) of the writer, guards layout changes
+    _Atomic uint64_t seq;
+    ShmViewData data;
+} ShmViewSeg;
+
+// writer: the segment is created afresh (a stale one of the same name is
+// unlinked first) and unlinked again by shmview_destroy
+typedef struct ShmView ShmView;
+ShmView     *shmview_create(const char *name);     // "/name" or "name"; NULL on failure
+ShmViewData *shmview_begin(ShmView *v);            // start an update, returns the data to write
+void         shmview_end(ShmView *v);              // publish it
+void         shmview_destroy(ShmView *v);          // mark not live, unmap, unlink
+
+// reader
+typedef struct ShmViewReader ShmViewReader;
+ShmViewReader *shmview_attach(const char *name);   // NULL if absent or not a session view
+int  shmview_read(ShmViewReader *r, ShmViewData *out);   // 1, or 0 if no stable copy after many tries
+void shmview_detach(ShmViewReader *r);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef STRPACK_H
+#define STRPACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SP_UNBOUNDED (-1)
+
+// Packed string stack: every string lives back-to-back in one byte buffer and
+// is addressed through an offset/length slot, so walking it never chases a
+// per-entry heap pointer. With cap > 0 it behaves like Ring (oldest dropped
+// when full); with SP_UNBOUNDED it is a plain stack like Vec. Each entry
+// carries a timestamp (0 = unknown) that moves with it.
+typedef struct { size_t off, len; int64_t ts; } SPSlot;
+
+typedef struct {
+char   *bytes;      // NUL-terminated strings, oldest first
+size_t  used;       // bytes in use, including the dead prefix
+size_t  bcap;
+size_t  dead;       // bytes at the front still held by evicted entries
+SPSlot *slot;
+int     first;      // index of the oldest live slot
+int     size;       // number of items
+int     scap;
+int     cap;        // max items, or SP_UNBOUNDED
+} StrPack;
+
+
+void sp_init(StrPack *s, int cap);
+void sp_clear(StrPack *s);
+void sp_free(StrPack *s); // clear + release buffers
+void sp_copy(StrPack *dst, const StrPack *src); // dst becomes a copy (cap included): two block copies
+
+
+void sp_push(StrPack *s, const char *str); // copies, drops oldest if full
+void sp_push_ts(StrPack *s, const char *str, int64_t ts);
+char *sp_pop(StrPack *s); // returns malloc'd copy of newest, NULL if empty
+char *sp_pop_ts(StrPack *s, int64_t *ts); // same, and the entry's timestamp
+void sp_drop_front(StrPack *s); // evict oldest
+const char *sp_at(const StrPack *s, int i); // i=0..size-1 oldest..newest
+size_t sp_len(const StrPack *s, int i);
+int64_t sp_ts(const StrPack *s, int i);
+void sp_set_ts(StrPack *s, int i, int64_t ts);
+int sp_full(const StrPack *s);
+size_t sp_bytes(const StrPack *s); // live strings + slots, what dropping entries gives back
+
+
+#endif // STRPACK_H
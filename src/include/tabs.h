@@ -4,6 +4,25 @@
 
 #include "browser.h"
 #include "bookmarks.h"   
+#include "search.h"
+#include "domain.h"
+#include "timeidx.h"
+#include "predict.h"
+#include "shmview.h"
+
+
+// Bytes held by a manager's tabs, its undo stack, its bookmarks and the
+// next-visit model, against an optional limit (mem_settle in features.h
+// enforces it). Tabs are
+// re-charged lazily: a history change queues the tab, the next settle
+// measures it again.
+typedef struct {
+    size_t limit;                   // 0 = no limit
+    size_t tabs, undo, bookmarks, pred;   // bytes charged
+    unsigned bm_ver;                // bookmarks version charged
+    Browser **dirty; int ndirty, dirty_cap;
+    long evicted, spilled, undo_dropped, pred_dropped, passes;
+} MemBudget;
 
 
 typedef struct {
@@ -17,14 +36,33 @@ typedef struct {
     int  autosave;         // 0/1
     char autosave_path[260];
     BMList bookmarks;      
+
+    char spill_dir[260];   // cold-tier directory for back history, "" = off
+    int  spill_seq;        // per-tab segment file counter
+    int  spill_inst;       // this manager's number within the process
+
+    unsigned next_uid;     // Browser.uid source, 0 is reserved for bookmarks
+    UrlIndex search;       // trigram index over all tabs' history + bookmarks
+    DomainIndex domains;   // host -> tabs showing it + history counts
+    TimeIndex times;       // every timestamped history entry, by visit time
+    Predictor pred;        // next-visit model, fed by every visit in every tab
+    int unindexed;         // scratch manager (diff/merge): tabs get no hooks, indexes stay empty
+    MemBudget mem;
+    ShmView *view;         // shared-memory view published after each command, not owned; NULL = off
 } TabManager;
 
 void tm_init(TabManager *tm, int back_cap_default);
 int tm_new_tab(TabManager *tm, const char *homepage);
+int tm_adopt_tab(TabManager *tm, Browser *b);   // append an existing tab (load/reopen), returns id
+void tm_set_spill_dir(TabManager *tm, const char *dir_or_null);
+void tm_rebind(TabManager *tm);   // re-point tab hooks after a TabManager was copied by value
+int  tm_bookmark_add(TabManager *tm, const char *name, const char *url);
 void tm_close_tab(TabManager *tm, int id);
+void tm_replace_tab(TabManager *tm, int id, Browser *b);   // b takes over slot id, the old tab is destroyed
 void tm_switch(TabManager *tm, int id);
 Browser *tm_active(TabManager *tm);
 void tm_destroy(TabManager *tm);
+void tm_mem_touch(TabManager *tm, Browser *b);   // queue b to be charged again at the next settle
 
 
 
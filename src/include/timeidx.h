@@ -0,0 +1,32 @@
+#ifndef TIMEIDX_H
+#define TIMEIDX_H
+
+#include <stdint.h>
+
+struct Browser;
+
+// Session-wide visit index ordered by time: one entry per timestamped
+// history entry of every tab. New visits arrive in time order and are simply
+// appended; out-of-order arrivals (a session being loaded tab by tab) are
+// batched and merged in one pass before the next lookup. Removals leave
+// tombstones that are compacted away once they dominate.
+typedef struct {
+    int64_t ts;
+    unsigned uid;              // owning tab's uid, breaks ties between tabs
+    struct Browser *tab;       // NULL once removed
+    const char *url;           // borrowed, see TabManager's UrlIndex
+} TVisit;
+
+typedef struct {
+    TVisit *v; int n, cap, dead;   // sorted by (ts, uid)
+    TVisit *pend; int npend, cpend;
+} TimeIndex;
+
+void timeidx_init(TimeIndex *ix);
+void timeidx_free(TimeIndex *ix);
+void timeidx_add(TimeIndex *ix, struct Browser *tab, const char *url, int64_t ts);   // ts 0 is not indexed
+void timeidx_remove(TimeIndex *ix, struct Browser *tab, const char *url, int64_t ts);  // url tells apart visits sharing a stamp
+int  timeidx_query(TimeIndex *ix, int64_t since, int64_t until, TVisit **out);       // live visits in [since, until], oldest first
+int  timeidx_count(TimeIndex *ix);
+
+#endif
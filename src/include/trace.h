@@ -0,0 +1,45 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+// Event tracing, compiled in with -DBROWSER_TRACE (make TRACE=1). Each trace
+// point brackets a call and records one complete event (name, start,
+// duration, optional short argument) into a ring owned by the calling thread,
+// so recording takes no lock. While tracing is off a trace point costs one
+// relaxed load and a branch. `trace dump` writes Chrome trace_event JSON
+// (chrome://tracing, Perfetto). Without BROWSER_TRACE the macros vanish and
+// the functions below report that tracing is unavailable.
+
+int  trace_available(void);           // compiled in
+void trace_set(int on);
+int  trace_is_on(void);
+void trace_clear(void);               // forget what the rings hold so far
+int  trace_dump(const char *path);    // events written, -1 if the file could not be written
+
+#ifdef BROWSER_TRACE
+#include <stdatomic.h>
+
+extern atomic_int trace_enabled_;
+
+typedef struct { const char *name; uint64_t t0; } TraceSpan;   // t0 == 0: not recording
+
+uint64_t trace_now(void);             // monotonic ns
+void     trace_record(const char *name, uint64_t t0, const char *arg);
+
+static inline TraceSpan trace_begin(const char *name) {
+    TraceSpan s = { name, 0 };
+    if (atomic_load_explicit(&trace_enabled_, memory_order_relaxed)) s.t0 = trace_now();
+    return s;
+}
+
+#define TRACE_BEGIN(sp, name)    TraceSpan sp = trace_begin(name)
+#define TRACE_END(sp)            do { if ((sp).t0) trace_record((sp).name, (sp).t0, NULL); } while (0)
+#define TRACE_END_ARG(sp, arg)   do { if ((sp).t0) trace_record((sp).name, (sp).t0, (arg)); } while (0)
+#else
+#define TRACE_BEGIN(sp, name)    ((void)0)
+#define TRACE_END(sp)            ((void)0)
+#define TRACE_END_ARG(sp, arg)   ((void)0)
+#endif
+
+#endif
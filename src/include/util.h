@@ -1,8 +1,15 @@
 #ifndef UTIL_H
 #define UTIL_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+#define FNV1A64_SEED 0xcbf29ce484222325ULL
 
 char *sdup(const char *s); // strdup-like helper (mallocs)
+uint64_t fnv1a64(const void *p, size_t n, uint64_t h); // chainable: pass the previous hash as h
+int64_t wall_ms(void); // ms since the Unix epoch
+int parse_bytes(const char *s, size_t *out); // 4096, 512K, 64M, 2G (powers of 1024); 0 if malformed
 
 
-#endif // UTIL_H
\ No newline at end of file
+#endif // UTIL_H
@@ -0,0 +1,112 @@
+// tools/replay.c — deterministic replay harness for command streams
+//
+// Feeds every line of a workload (e.g. from wlgen) through process_command
+// at full speed, discarding the command output, and reports throughput,
+// per-command latency percentiles and peak RSS on stderr.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tabs.h"
+#include "commands.h"
+#include "features.h"
+#include "util.h"       // parse_bytes
+
+#if defined(_WIN32) || defined(_WIN64)
+  #define NULL_DEVICE "NUL"
+#else
+  #include <sys/resource.h>
+  #define NULL_DEVICE "/dev/null"
+#endif
+
+static double now_us(void) {
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static long peak_rss_kb(void) {
+#if defined(_WIN32) || defined(_WIN64)
+    return -1;
+#else
+    struct rusage ru; getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;   // kilobytes on Linux
+#endif
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double pct(const double *v, size_t n, double p) {
+    size_t i = (size_t)(p / 100.0 * (double)(n - 1) + 0.5);
+    return v[i];
+}
+
+int main(int argc, char **argv) {
+    int back_cap = 5;
+    const char *path = NULL, *spill = NULL;
+    size_t mem_limit = 0;
+    int bad = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--back-cap") == 0 && i + 1 < argc) back_cap = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--spill-dir") == 0 && i + 1 < argc) spill = argv[++i];
+        else if (strcmp(argv[i], "--mem-limit") == 0 && i + 1 < argc) bad |= !parse_bytes(argv[++i], &mem_limit);
+        else if (!path) path = argv[i];
+        else bad = 1;
+    }
+    if (!path || bad) {
+        fprintf(stderr, "usage: %s [--back-cap N] [--spill-dir DIR] [--mem-limit N[K|M|G]] <workload.txt|->\n", argv[0]);
+        return 1;
+    }
+    FILE *in = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (!in) { perror("open"); return 1; }
+
+    // slurp first so file I/O stays out of the timings
+    size_t n = 0, cap = 1 << 16;
+    char **lines = (char**)malloc(cap * sizeof(char*));
+    char line[4096];
+    while (fgets(line, sizeof line, in)) {
+        if (n == cap) { cap <<= 1; lines = (char**)realloc(lines, cap * sizeof(char*)); }
+        size_t L = strlen(line) + 1;
+        lines[n] = (char*)malloc(L); memcpy(lines[n], line, L); n++;
+    }
+    if (in != stdin) fclose(in);
+    if (n == 0) { fprintf(stderr, "empty workload\n"); free(lines); return 1; }
+
+    fflush(stdout);
+    if (!freopen(NULL_DEVICE, "w", stdout)) { perror("freopen"); return 1; }
+
+    TabManager tm; tm_init(&tm, back_cap);
+    if (spill) tm_set_spill_dir(&tm, spill);
+    tm.mem.limit = mem_limit;
+    UndoStack undo; undo_init(&undo);
+    tm_new_tab(&tm, "about:blank");
+
+    double *lat = (double*)malloc(n * sizeof(double));
+    size_t done = 0;
+    double t0 = now_us();
+    for (; done < n; ++done) {
+        double a = now_us();
+        int go = process_command(&tm, &undo, lines[done], stdout);
+        lat[done] = now_us() - a;
+        if (!go) { ++done; break; }
+    }
+    double secs = (now_us() - t0) / 1e6;
+
+    qsort(lat, done, sizeof(double), cmp_double);
+    fprintf(stderr, "replay: %zu commands in %.3f s (%.0f cmd/s)\n", done, secs, (double)done / (secs > 0 ? secs : 1e-9));
+    fprintf(stderr, "latency us: p50 %.2f  p90 %.2f  p99 %.2f  p99.9 %.2f  max %.2f\n",
+            pct(lat, done, 50), pct(lat, done, 90), pct(lat, done, 99), pct(lat, done, 99.9), lat[done - 1]);
+    fprintf(stderr, "tabs %d, peak RSS %ld KB\n", tm.count, peak_rss_kb());
+    if (mem_limit)
+        fprintf(stderr, "mem limit %zu KB: %zu KB charged, %ld entries evicted, %ld spilled, %ld model urls dropped, %ld passes\n",
+                mem_limit >> 10, mem_used(&tm) >> 10, tm.mem.evicted, tm.mem.spilled, tm.mem.pred_dropped, tm.mem.passes);
+
+    tm_destroy(&tm); undo_destroy(&undo);
+    for (size_t i = 0; i < n; ++i) free(lines[i]);
+    free(lines); free(lat);
+    return 0;
+}
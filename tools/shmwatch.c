@@ -0,0 +1,74 @@
+// tools/shmwatch.c — example monitor for the shared-memory session view
+//
+// Attaches to the view of a browser started with --shm <name> and prints a
+// snapshot, once or every interval. Built only from src/app/shmview.c, the
+// same way an outside monitor would use it. --bench times shmview_read.
+//
+//   shmwatch <name> [-i ms] [-n count] [--bench reads]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "shmview.h"
+
+static double now_us(void) {
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void sleep_ms(int ms) {
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static void show(const ShmViewData *d) {
+    printf("pid %d%s  update %llu  tabs %d  active %d  bookmarks %d  closed %d  predicted %d\n",
+           (int)d->pid, d->live ? "" : " (exited)", (unsigned long long)d->updates, (int)d->count,
+           (int)d->active, (int)d->bookmarks, (int)d->closed, (int)d->predicted);
+    printf("mem %llu / %llu  evicted %lld  spilled %lld  undo dropped %lld\n",
+           (unsigned long long)d->mem_used, (unsigned long long)d->mem_limit,
+           (long long)d->evicted, (long long)d->spilled, (long long)d->undo_dropped);
+    for (int i = 0; i < d->count && i < SHMV_TABS; ++i) {
+        const ShmViewTab *t = &d->tab[i];
+        printf("[%d]%s %s%s  (back %d, forward %d)\n", i, i == d->active ? "*" : " ", t->url,
+               t->url_len > SHMV_URL - 1 ? "..." : "", (int)t->back, (int)t->forward);
+    }
+    if (d->count > SHMV_TABS) printf("(+%d tabs not shown)\n", (int)d->count - SHMV_TABS);
+}
+
+int main(int argc, char **argv) {
+    const char *name = NULL;
+    int interval = 0, count = 1, bench = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) { interval = atoi(argv[++i]); count = 0; }
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) count = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) bench = atoi(argv[++i]);
+        else if (argv[i][0] != '-' && !name) name = argv[i];
+        else { fprintf(stderr, "usage: %s <name> [-i ms] [-n count] [--bench reads]\n", argv[0]); return 2; }
+    }
+    if (!name) { fprintf(stderr, "usage: %s <name> [-i ms] [-n count] [--bench reads]\n", argv[0]); return 2; }
+
+    ShmViewReader *r = shmview_attach(name);
+    if (!r) { fprintf(stderr, "shmwatch: no session view named %s\n", name); return 1; }
+    ShmViewData *d = (ShmViewData*)malloc(sizeof(ShmViewData));
+
+    if (bench > 0) {
+        int ok = 0;
+        double t0 = now_us();
+        for (int i = 0; i < bench; ++i) ok += shmview_read(r, d);
+        double us = (now_us() - t0) / bench;
+        printf("shmwatch: %d reads, %d consistent, %.3f us/read (%d tabs)\n", bench, ok, us, (int)d->count);
+    } else {
+        for (int n = 0; !count || n < count; ++n) {
+            if (n) { sleep_ms(interval); putchar('\n'); }
+            if (!shmview_read(r, d)) { puts("(view busy: no consistent copy)"); continue; }
+            show(d);
+            if (!d->live) break;
+        }
+    }
+    free(d);
+    shmview_detach(r);
+    return 0;
+}
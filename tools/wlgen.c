@@ -0,0 +1,122 @@
+// tools/wlgen.c — synthetic workload generator for the browser command stream
+//
+// Emits one command per line on stdout. URL popularity follows a Zipf law
+// over a fixed universe, the command mix is configurable, and the output is
+// a pure function of the options, so a seed identifies a workload.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef struct { const char *name; int weight; } MixEnt;
+
+enum { M_VISIT, M_BACK, M_FORWARD, M_NEWTAB, M_CLOSE, M_REOPEN, M_BM, M_SWITCH, M_COUNT };
+
+static MixEnt mix[M_COUNT] = {
+    { "visit", 70 }, { "back", 10 }, { "forward", 5 }, { "newtab", 3 },
+    { "close", 3 },  { "reopen", 1 }, { "bm", 3 },     { "switch", 5 },
+};
+
+static unsigned long long rng_state;
+static unsigned long long rng(void) {   // xorshift64*
+    rng_state ^= rng_state >> 12; rng_state ^= rng_state << 25; rng_state ^= rng_state >> 27;
+    return rng_state * 2685821657736338717ULL;
+}
+static double rng01(void) { return (double)(rng() >> 11) / 9007199254740992.0; }
+static int rng_below(int n) { return (int)(rng() % (unsigned long long)n); }
+
+// rank r (0-based) has weight 1/(r+1)^s; sample by binary search on the CDF
+static double *zipf_cdf(int n, double s) {
+    double *cdf = (double*)malloc(sizeof(double) * (size_t)n), sum = 0;
+    for (int i = 0; i < n; ++i) { sum += 1.0 / pow(i + 1, s); cdf[i] = sum; }
+    for (int i = 0; i < n; ++i) cdf[i] /= sum;
+    return cdf;
+}
+static int zipf_pick(const double *cdf, int n) {
+    double u = rng01(); int lo = 0, hi = n - 1;
+    while (lo < hi) { int mid = (lo + hi) / 2; if (cdf[mid] < u) lo = mid + 1; else hi = mid; }
+    return lo;
+}
+
+// url rank -> stable url; hosts are shared so paths repeat under few domains
+static void url_for(char *out, size_t n, int rank, int hosts) {
+    snprintf(out, n, "https://www.site%d.example.com/section/%d/item-%d", rank % hosts, (rank / hosts) % 16, rank);
+}
+
+static int parse_mix(const char *spec) {
+    char buf[256]; strncpy(buf, spec, sizeof buf - 1); buf[sizeof buf - 1] = '\0';
+    for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+        char *eq = strchr(tok, '='); if (!eq) return 0;
+        *eq = '\0';
+        int k = 0; while (k < M_COUNT && strcmp(mix[k].name, tok) != 0) ++k;
+        if (k == M_COUNT) return 0;
+        mix[k].weight = atoi(eq + 1);
+    }
+    return 1;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "usage: %s [options] > workload.txt\n"
+        "  --seed N      rng seed (default 1)\n"
+        "  --cmds N      commands to emit (default 100000)\n"
+        "  --tabs N      target open tab count (default 16)\n"
+        "  --urls N      url universe size (default 100000)\n"
+        "  --hosts N     distinct hosts (default 500)\n"
+        "  --zipf S      popularity exponent (default 1.1)\n"
+        "  --mix SPEC    e.g. visit=70,back=10,forward=5,newtab=3,close=3,reopen=1,bm=3,switch=5\n", prog);
+}
+
+int main(int argc, char **argv) {
+    unsigned long long seed = 1;
+    int cmds = 100000, target_tabs = 16, urls = 100000, hosts = 500;
+    double zs = 1.1;
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i], *v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!v) { usage(argv[0]); return 1; }
+        if      (strcmp(a, "--seed") == 0)  seed = strtoull(v, NULL, 10);
+        else if (strcmp(a, "--cmds") == 0)  cmds = atoi(v);
+        else if (strcmp(a, "--tabs") == 0)  target_tabs = atoi(v);
+        else if (strcmp(a, "--urls") == 0)  urls = atoi(v);
+        else if (strcmp(a, "--hosts") == 0) hosts = atoi(v);
+        else if (strcmp(a, "--zipf") == 0)  zs = atof(v);
+        else if (strcmp(a, "--mix") == 0)   { if (!parse_mix(v)) { usage(argv[0]); return 1; } }
+        else { usage(argv[0]); return 1; }
+        ++i;
+    }
+    if (urls < 1 || hosts < 1 || target_tabs < 1) { usage(argv[0]); return 1; }
+    rng_state = seed * 0x9E3779B97F4A7C15ULL + 1;
+
+    double *cdf = zipf_cdf(urls, zs);
+    int total = 0; for (int k = 0; k < M_COUNT; ++k) total += mix[k].weight;
+    if (total <= 0) { usage(argv[0]); free(cdf); return 1; }
+
+    // mirror just enough state to keep commands valid: the binary starts with one tab
+    int tabs = 1, closed = 0, bms = 0;
+    char url[160];
+    for (int i = 0; i < cmds; ++i) {
+        int r = rng_below(total), k = 0;
+        while (r >= mix[k].weight) r -= mix[k++].weight;
+        // steer the tab count towards the target
+        if (k == M_NEWTAB && tabs >= 2 * target_tabs) k = M_CLOSE;
+        if (k == M_CLOSE && tabs <= (target_tabs + 1) / 2) k = M_NEWTAB;
+        if (k == M_REOPEN && closed == 0) k = M_VISIT;
+
+        switch (k) {
+        case M_VISIT:   url_for(url, sizeof url, zipf_pick(cdf, urls), hosts); printf("visit %s\n", url); break;
+        case M_BACK:    printf("back %d\n", 1 + rng_below(3)); break;
+        case M_FORWARD: printf("forward %d\n", 1 + rng_below(2)); break;
+        case M_NEWTAB:  url_for(url, sizeof url, zipf_pick(cdf, urls), hosts); printf("newtab %s\n", url); tabs++; break;
+        case M_CLOSE:   printf("close %d\n", rng_below(tabs)); tabs--; closed++; break;
+        case M_REOPEN:  printf("reopen\n"); tabs++; closed--; break;
+        case M_SWITCH:  printf("switch %d\n", rng_below(tabs)); break;
+        case M_BM:
+            if (bms > 0 && rng_below(2)) printf("bm open bm%d\n", zipf_pick(cdf, bms < urls ? bms : urls) % bms);
+            else { url_for(url, sizeof url, zipf_pick(cdf, urls), hosts); printf("bm add bm%d %s\n", bms++, url); }
+            break;
+        }
+    }
+    free(cdf);
+    return 0;
+}